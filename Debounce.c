@@ -0,0 +1,102 @@
+/** \file
+ *
+ *  Vertical counter debouncing. Every input in a lane has a small counter, stored as bit
+ *  planes (bit 0 of all counters in one byte, bit 1 in another and so on), so a whole
+ *  port is debounced with a handful of byte operations and no branches per input.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include "Debounce.h"
+
+/** Current settings, as given to Debounce_SetConfig(). */
+static Debounce_Config_t debounceConfig;
+
+/** Press, release and lockout windows expanded to bit planes: plane n is 0xFF if bit n of the window is set. */
+static uint8_t pressPlanes[3];
+static uint8_t releasePlanes[3];
+static uint8_t lockoutPlanes[3];
+
+static uint8_t ClampTicks(uint8_t ticks)
+{
+	if (ticks < 1) {
+		return 1;
+	}
+	if (ticks > DEBOUNCE_MAX_TICKS) {
+		return DEBOUNCE_MAX_TICKS;
+	}
+	return ticks;
+}
+
+static void ExpandPlanes(uint8_t planes[3], uint8_t ticks)
+{
+	uint8_t i;
+	for (i = 0; i < 3; ++i) {
+		planes[i] = (ticks & (1 << i)) ? 0xFF : 0x00;
+	}
+}
+
+/** Change the debounce settings. Windows out of range are clamped. */
+void Debounce_SetConfig(const Debounce_Config_t* const Config)
+{
+	debounceConfig.PressTicks = ClampTicks(Config->PressTicks);
+	debounceConfig.ReleaseTicks = ClampTicks(Config->ReleaseTicks);
+	debounceConfig.LockoutTicks = ClampTicks(Config->LockoutTicks);
+	debounceConfig.Eager = Config->Eager;
+
+	ExpandPlanes(pressPlanes, debounceConfig.PressTicks);
+	ExpandPlanes(releasePlanes, debounceConfig.ReleaseTicks);
+	ExpandPlanes(lockoutPlanes, debounceConfig.LockoutTicks);
+}
+
+/** Read back the current debounce settings. */
+void Debounce_GetConfig(Debounce_Config_t* const Config)
+{
+	*Config = debounceConfig;
+}
+
+/** Feed one raw sample (set bits are pressed) to a lane. Should be called once per tick. */
+void Debounce_Update(Debounce_Lane_t* const Lane, const uint8_t Sample)
+{
+	uint8_t delta = Sample ^ Lane->State;
+	uint8_t c0 = Lane->Count0;
+	uint8_t c1 = Lane->Count1;
+	uint8_t c2 = Lane->Count2;
+	uint8_t toggle;
+
+	if (debounceConfig.Eager) {
+		/* Counters hold the remaining lockout. Unlocked inputs follow the sample at once. */
+		uint8_t locked = c0 | c1 | c2;
+		uint8_t borrow0 = locked & ~c0;
+		uint8_t borrow1 = borrow0 & ~c1;
+
+		toggle = delta & ~locked;
+		c2 ^= borrow1;
+		c1 ^= borrow0;
+		c0 ^= locked;
+
+		c0 = (c0 & ~toggle) | (lockoutPlanes[0] & toggle);
+		c1 = (c1 & ~toggle) | (lockoutPlanes[1] & toggle);
+		c2 = (c2 & ~toggle) | (lockoutPlanes[2] & toggle);
+	} else {
+		/* Counters hold how long each input has disagreed with its state. Agreeing inputs restart. */
+		uint8_t pressed = Lane->State;
+		uint8_t t0 = (pressed & releasePlanes[0]) | (~pressed & pressPlanes[0]);
+		uint8_t t1 = (pressed & releasePlanes[1]) | (~pressed & pressPlanes[1]);
+		uint8_t t2 = (pressed & releasePlanes[2]) | (~pressed & pressPlanes[2]);
+
+		c2 = (c2 ^ (c1 & c0)) & delta;
+		c1 = (c1 ^ c0) & delta;
+		c0 = ~c0 & delta;
+
+		toggle = delta & ~((c0 ^ t0) | (c1 ^ t1) | (c2 ^ t2));
+		c0 &= ~toggle;
+		c1 &= ~toggle;
+		c2 &= ~toggle;
+	}
+
+	Lane->State ^= toggle;
+	Lane->Count0 = c0;
+	Lane->Count1 = c1;
+	Lane->Count2 = c2;
+}
+
@@ -0,0 +1,54 @@
+/** \file
+ *
+ *  Header file for Debounce.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _DEBOUNCE_H_
+#define _DEBOUNCE_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+	/* Macros: */
+		/** Largest press, release or lockout window accepted, in ticks. Limited by the 3-bit counters. */
+		#define DEBOUNCE_MAX_TICKS           7
+
+		/** Default number of ticks an input must read pressed before the press is reported. */
+		#define DEBOUNCE_PRESS_TICKS         3
+
+		/** Default number of ticks an input must read released before the release is reported. */
+		#define DEBOUNCE_RELEASE_TICKS       3
+
+		/** Default number of ticks an input is locked after an edge, in eager mode. */
+		#define DEBOUNCE_LOCKOUT_TICKS       5
+
+	/* Type Defines: */
+		/** Debounce settings. Windows are given in ticks, one tick per USB start of frame (1 ms). */
+		typedef struct
+		{
+			uint8_t PressTicks; /**< Consecutive pressed samples needed to report a press, 1 to \ref DEBOUNCE_MAX_TICKS. */
+			uint8_t ReleaseTicks; /**< Consecutive released samples needed to report a release, 1 to \ref DEBOUNCE_MAX_TICKS. */
+			uint8_t LockoutTicks; /**< In eager mode, ticks the input ignores changes after an edge, 1 to \ref DEBOUNCE_MAX_TICKS. */
+			bool    Eager; /**< Report the first edge immediately, then lock the input out instead of integrating. */
+		} Debounce_Config_t;
+
+		/** Debounce state for up to eight inputs sharing a byte, such as the pins of one port.
+		 *  Each input has a 3-bit counter, stored as bit planes so all eight are updated at once.
+		 */
+		typedef struct
+		{
+			uint8_t State; /**< Debounced inputs, set bits are pressed. */
+			uint8_t Count0; /**< Bit 0 of the per-input counters. */
+			uint8_t Count1; /**< Bit 1 of the per-input counters. */
+			uint8_t Count2; /**< Bit 2 of the per-input counters. */
+		} Debounce_Lane_t;
+
+	/* Function Prototypes: */
+		void Debounce_SetConfig(const Debounce_Config_t* const Config);
+		void Debounce_GetConfig(Debounce_Config_t* const Config);
+		void Debounce_Update(Debounce_Lane_t* const Lane, const uint8_t Sample);
+
+#endif
+
@@ -38,6 +38,9 @@
 
 #include "Descriptors.h"
 
+_Static_assert(JOYSTICK_REPORT_BITS % 8 == 0, "Joystick report is not a whole number of bytes");
+_Static_assert(JOYSTICK_REPORT_BITS / 8 + 1 <= JOYSTICK_EPSIZE, "Joystick report and its ID do not fit the endpoint");
+
 /** HID class report descriptor. This is a special descriptor constructed with values from the
  *  USBIF HID class specification to describe the reports and capabilities of the HID device. This
  *  descriptor is parsed by the host and its contents used to determine what data (and in what encoding)
@@ -47,42 +50,40 @@
 const USB_Descriptor_HIDReport_Datatype_t PROGMEM JoystickReport[] =
 {
 /*
- * Descriptor created using HID Descriptor Tool from usb.org.
- * Gamepad with two axes (X and Y) and 10 buttons.
+ * Gamepad with two axes (X and Y) and 10 buttons, plus a vendor feature report holding the
+ * device configuration (see USB_JoystickConfigReport_Data_t in Joystick.h) and, when input edges are
+ * timed (TRACK_EDGE_LATENCY in Joystick.h), another one holding the latency statistics (see
+ * USB_JoystickStatsReport_Data_t).
  *
- * The data described by this descriptor consists of 4 bytes:
+ * The input report is prefixed with its report ID, then holds the fields of JOYSTICK_REPORT_FIELDS:
  *     B08 B07 B06 B05 B04 B03 B02 B01 .... Two bytes with buttons plus padding.
  *       .   .   .   .   .   . B10 B09
  *      X7  X6  X5  X4  X3  X2  X1  X0 .... 8 bit signed relative coordinate x.
  *      Y7  Y6  Y5  Y4  Y3  Y2  Y1  Y0 .... 8 bit signed relative coordinate y.
  */
 
-	0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
-	0x09, 0x05,                    // USAGE (Game Pad)
-	0xa1, 0x01,                    // COLLECTION (Application)
-	0xa1, 0x00,                    //   COLLECTION (Physical)
-	0x05, 0x09,                    //     USAGE_PAGE (Button)
-	0x19, 0x01,                    //     USAGE_MINIMUM (Button 1)
-	0x29, 0x0a,                    //     USAGE_MAXIMUM (Button 10)
-	0x15, 0x00,                    //     LOGICAL_MINIMUM (0)
-	0x25, 0x01,                    //     LOGICAL_MAXIMUM (1)
-	0x75, 0x01,                    //     REPORT_SIZE (1)
-	0x95, 0x0a,                    //     REPORT_COUNT (10)
-	0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-	0x75, 0x06,                    //     REPORT_SIZE (6)
-	0x95, 0x01,                    //     REPORT_COUNT (1)
-	0x81, 0x03,                    //     INPUT (Cnst,Var,Abs)
-	0x05, 0x01,                    //     USAGE_PAGE (Generic Desktop)
-	0x09, 0x30,                    //     USAGE (X)
-	0x09, 0x31,                    //     USAGE (Y)
-	0x15, 0x00,                    //     LOGICAL_MINIMUM (0)
-	0x26, 0xff, 0x00,              //     LOGICAL_MAXIMUM (255)
-	0x75, 0x08,                    //     REPORT_SIZE (8)
-	0x95, 0x02,                    //     REPORT_COUNT (2)
-	0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-	0xc0,                          //     END_COLLECTION
-	0xc0                           // END_COLLECTION
-
+	HID_RI_USAGE_PAGE(8, 0x01),                       // Generic Desktop
+	HID_RI_USAGE(8, 0x05),                            // Game Pad
+	HID_RI_COLLECTION(8, 0x01),                       // Application
+		HID_RI_REPORT_ID(8, HID_REPORTID_Joystick),
+		HID_RI_COLLECTION(8, 0x00),                   // Physical
+			JOYSTICK_REPORT_FIELDS(REPORT_LAYOUT_INPUT)
+		HID_RI_END_COLLECTION(0),
+		HID_RI_REPORT_ID(8, HID_REPORTID_Config),
+		HID_RI_USAGE_PAGE(16, 0xFF00),                // Vendor Defined Page 1
+		HID_RI_USAGE(8, 0x01),                        // Vendor Usage 1
+		HID_RI_LOGICAL_MINIMUM(8, 0),
+		HID_RI_LOGICAL_MAXIMUM(16, 255),
+		HID_RI_REPORT_SIZE(8, 8),
+		HID_RI_REPORT_COUNT(8, JOYSTICK_CONFIG_REPORT_SIZE),
+		HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+#if defined(LOW_LATENCY_MODE) || defined(LATENCY_STATS)
+		HID_RI_REPORT_ID(8, HID_REPORTID_Stats),
+		HID_RI_USAGE(8, 0x02),                        // Vendor Usage 2
+		HID_RI_REPORT_COUNT(8, JOYSTICK_STATS_REPORT_SIZE),
+		HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+#endif
+	HID_RI_END_COLLECTION(0),
 };
 
 /** Device descriptor structure. This descriptor, located in FLASH memory, describes the overall
@@ -169,10 +170,17 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor =
 			.EndpointAddress        = JOYSTICK_EPADDR,
 			.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
 			.EndpointSize           = JOYSTICK_EPSIZE,
-			.PollingIntervalMS      = 0x05
+			.PollingIntervalMS      = JOYSTICK_POLLING_MS
 		}
 };
 
+/** Manufacturer and product strings, kept as macros so their descriptor sizes are known at compile time. */
+#define MANUFACTURER_STRING  L"streetomon@gmail.com"
+#define PRODUCT_STRING       L"PancadariaStick"
+
+/** Size in bytes of a string descriptor built by USB_STRING_DESCRIPTOR() from a wide string literal. */
+#define STRING_DESCRIPTOR_SIZE(String) (sizeof(USB_Descriptor_Header_t) + sizeof(String) - 2)
+
 /** Language descriptor structure. This descriptor, located in FLASH memory, is returned when the host requests
  *  the string descriptor with index 0 (the first index). It is actually an array of 16-bit integers, which indicate
  *  via the language ID table available at USB.org what languages the device supports for its string descriptors.
@@ -183,13 +191,56 @@ const USB_Descriptor_String_t PROGMEM LanguageString = USB_STRING_DESCRIPTOR_ARR
  *  form, and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
  *  Descriptor.
  */
-const USB_Descriptor_String_t PROGMEM ManufacturerString = USB_STRING_DESCRIPTOR(L"streetomon@gmail.com");
+const USB_Descriptor_String_t PROGMEM ManufacturerString = USB_STRING_DESCRIPTOR(MANUFACTURER_STRING);
 
 /** Product descriptor string. This is a Unicode string containing the product's details in human readable form,
  *  and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
  *  Descriptor.
  */
-const USB_Descriptor_String_t PROGMEM ProductString = USB_STRING_DESCRIPTOR(L"PancadariaStick");
+const USB_Descriptor_String_t PROGMEM ProductString = USB_STRING_DESCRIPTOR(PRODUCT_STRING);
+
+/** Descriptors returned for GET_DESCRIPTOR requests, sorted by type and index. Each entry gives the type and
+ *  index of a descriptor, its address in FLASH memory and its size, resolved at compile time.
+ */
+#define DESCRIPTOR_ENTRIES(ENTRY) \
+	ENTRY(DTYPE_Device, 0, &DeviceDescriptor, sizeof(USB_Descriptor_Device_t)) \
+	ENTRY(DTYPE_Configuration, 0, &ConfigurationDescriptor, sizeof(USB_Descriptor_Configuration_t)) \
+	ENTRY(DTYPE_String, STRING_ID_Language, &LanguageString, sizeof(USB_Descriptor_Header_t) + sizeof(uint16_t)) \
+	ENTRY(DTYPE_String, STRING_ID_Manufacturer, &ManufacturerString, STRING_DESCRIPTOR_SIZE(MANUFACTURER_STRING)) \
+	ENTRY(DTYPE_String, STRING_ID_Product, &ProductString, STRING_DESCRIPTOR_SIZE(PRODUCT_STRING)) \
+	ENTRY(HID_DTYPE_HID, 0, &ConfigurationDescriptor.HID_JoystickHID, sizeof(USB_HID_Descriptor_HID_t)) \
+	ENTRY(HID_DTYPE_Report, 0, &JoystickReport, sizeof(JoystickReport))
+
+/** Expand an entry into a member of DescriptorTable. */
+#define DESCRIPTOR_ENTRY_TABLE(Type, Index, Address, Size) \
+	{DESCRIPTOR_VALUE(Type, Index), Address, Size},
+
+/** Expand an entry into enumerators: DESCRIPTOR_AFTER_Type_Index follows the value of the previous entry, and
+ *  DESCRIPTOR_AT_Type_Index is the value of this one. A repeated entry does not compile.
+ */
+#define DESCRIPTOR_ENTRY_ORDER(Type, Index, Address, Size) \
+	DESCRIPTOR_AFTER_##Type##_##Index, DESCRIPTOR_AT_##Type##_##Index = DESCRIPTOR_VALUE(Type, Index),
+
+/** Expand an entry into a check that its value is above the value of the previous entry. */
+#define DESCRIPTOR_ENTRY_SORTED(Type, Index, Address, Size) \
+	_Static_assert(DESCRIPTOR_AT_##Type##_##Index >= DESCRIPTOR_AFTER_##Type##_##Index, \
+	               "DescriptorTable is not sorted at " #Type ", " #Index);
+
+/** Values of the descriptor entries, in table order, see \ref DESCRIPTOR_ENTRY_ORDER. */
+enum DescriptorOrder_t
+{
+	DESCRIPTOR_ENTRIES(DESCRIPTOR_ENTRY_ORDER)
+};
+
+DESCRIPTOR_ENTRIES(DESCRIPTOR_ENTRY_SORTED)
+
+/** Table of all descriptors, sorted by \c Value so CALLBACK_USB_GetDescriptor() can binary search it. The table
+ *  is a global symbol, so host tools can dump it from the ELF file to verify the descriptors.
+ */
+const USB_Descriptor_Entry_t PROGMEM DescriptorTable[] =
+{
+	DESCRIPTOR_ENTRIES(DESCRIPTOR_ENTRY_TABLE)
+};
 
 /** This function is called by the library when in device mode, and must be overridden (see library "USB Descriptors"
  *  documentation) by the application code so that the address and size of a requested descriptor can be given
@@ -201,51 +252,28 @@ uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
                                     const uint8_t wIndex,
                                     const void** const DescriptorAddress)
 {
-	const uint8_t  DescriptorType   = (wValue >> 8);
-	const uint8_t  DescriptorNumber = (wValue & 0xFF);
-
-	const void* Address = NULL;
-	uint16_t    Size    = NO_DESCRIPTOR;
+	USB_Descriptor_Entry_t Entry;
+	uint8_t Low  = 0;
+	uint8_t High = sizeof(DescriptorTable) / sizeof(DescriptorTable[0]);
 
-	switch (DescriptorType)
+	while (Low < High)
 	{
-		case DTYPE_Device:
-			Address = &DeviceDescriptor;
-			Size    = sizeof(USB_Descriptor_Device_t);
-			break;
-		case DTYPE_Configuration:
-			Address = &ConfigurationDescriptor;
-			Size    = sizeof(USB_Descriptor_Configuration_t);
-			break;
-		case DTYPE_String:
-			switch (DescriptorNumber)
-			{
-				case STRING_ID_Language:
-					Address = &LanguageString;
-					Size    = pgm_read_byte(&LanguageString.Header.Size);
-					break;
-				case STRING_ID_Manufacturer:
-					Address = &ManufacturerString;
-					Size    = pgm_read_byte(&ManufacturerString.Header.Size);
-					break;
-				case STRING_ID_Product:
-					Address = &ProductString;
-					Size    = pgm_read_byte(&ProductString.Header.Size);
-					break;
-			}
-
-			break;
-		case HID_DTYPE_HID:
-			Address = &ConfigurationDescriptor.HID_JoystickHID;
-			Size    = sizeof(USB_HID_Descriptor_HID_t);
-			break;
-		case HID_DTYPE_Report:
-			Address = &JoystickReport;
-			Size    = sizeof(JoystickReport);
-			break;
+		uint8_t  Middle = (Low + High) / 2;
+		uint16_t Value  = pgm_read_word(&DescriptorTable[Middle].Value);
+
+		if (Value == wValue)
+		{
+			memcpy_P(&Entry, &DescriptorTable[Middle], sizeof(USB_Descriptor_Entry_t));
+			*DescriptorAddress = Entry.Address;
+			return Entry.Size;
+		}
+
+		if (Value < wValue)
+		  Low  = Middle + 1;
+		else
+		  High = Middle;
 	}
 
-	*DescriptorAddress = Address;
-	return Size;
+	*DescriptorAddress = NULL;
+	return NO_DESCRIPTOR;
 }
-
@@ -41,6 +41,7 @@
 		#include <avr/pgmspace.h>
 
 		#include "LUFA/Drivers/USB/USB.h"
+		#include "ReportLayout.h"
 
 	/* Type Defines: */
 		/** Type define for the device configuration descriptor structure. This must be defined in the
@@ -57,6 +58,16 @@
 	        USB_Descriptor_Endpoint_t             HID_ReportINEndpoint;
 		} USB_Descriptor_Configuration_t;
 
+		/** Type define for an entry of the descriptor table, giving the address and size of the descriptor returned
+		 *  for a GET_DESCRIPTOR request.
+		 */
+		typedef struct
+		{
+			uint16_t    Value; /**< Request wValue, see \ref DESCRIPTOR_VALUE. */
+			const void* Address; /**< Address of the descriptor in FLASH memory. */
+			uint16_t    Size; /**< Size of the descriptor in bytes. */
+		} USB_Descriptor_Entry_t;
+
 		/** Enum for the device interface descriptor IDs within the device. Each interface descriptor
 		 *  should have a unique ID index associated with it, which can be used to refer to the
 		 *  interface from other descriptors.
@@ -77,13 +88,61 @@
 			STRING_ID_Product      = 2, /**< Product string ID */
 		};
 
+		/** Enum for the HID report IDs used in the device. */
+		enum JoystickReportIDs_t
+		{
+			HID_REPORTID_Joystick  = 0x01, /**< Joystick input report ID */
+			HID_REPORTID_Config    = 0x02, /**< Configuration feature report ID */
+			HID_REPORTID_Stats     = 0x03, /**< Latency statistics feature report ID */
+		};
+
 	/* Macros: */
+		/** GET_DESCRIPTOR request wValue of a descriptor: its type in the high byte, its index in the low byte. */
+		#define DESCRIPTOR_VALUE(Type, Index) (((uint16_t)(Type) << 8) | (Index))
+
 		/** Endpoint address of the Joystick HID reporting IN endpoint. */
 		#define JOYSTICK_EPADDR              (ENDPOINT_DIR_IN | 1)
 
 		/** Size in bytes of the Joystick HID reporting IN endpoint. */
 		#define JOYSTICK_EPSIZE              8
 
+		/** Fields of the joystick input report, see ReportLayout.h. Expanded into the report descriptor in
+		 *  Descriptors.c and into USB_JoystickReport_Data_t in Joystick.h, so the two cannot drift apart.
+		 */
+		#define JOYSTICK_REPORT_FIELDS(FIELD) \
+			FIELD(JOYSTICK_REPORT, uint16_t, Buttons, 1, 10, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE, \
+			      (HID_RI_USAGE_PAGE(8, 0x09), HID_RI_USAGE_MINIMUM(8, 1), HID_RI_USAGE_MAXIMUM(8, 10), \
+			       HID_RI_LOGICAL_MINIMUM(8, 0), HID_RI_LOGICAL_MAXIMUM(8, 1), )) \
+			FIELD(JOYSTICK_REPORT, uint16_t, Padding, 6, 1, HID_IOF_CONSTANT | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE, ()) \
+			FIELD(JOYSTICK_REPORT, uint8_t, X, 8, 1, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE, \
+			      (HID_RI_USAGE_PAGE(8, 0x01), HID_RI_USAGE(8, 0x30), \
+			       HID_RI_LOGICAL_MINIMUM(8, 0), HID_RI_LOGICAL_MAXIMUM(16, 255), )) \
+			FIELD(JOYSTICK_REPORT, uint8_t, Y, 8, 1, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE, \
+			      (HID_RI_USAGE(8, 0x31), ))
+
+		/** Size in bytes of the vendor configuration feature report, see USB_JoystickConfigReport_Data_t. */
+		#define JOYSTICK_CONFIG_REPORT_SIZE  28
+
+		/** Size in bytes of the vendor latency statistics feature report, see USB_JoystickStatsReport_Data_t. */
+		#define JOYSTICK_STATS_REPORT_SIZE   84
+
+		/** Polling interval in milliseconds of the Joystick HID reporting IN endpoint. The low latency
+		 *  mode asks the host for a report every frame.
+		 */
+		#if defined(LOW_LATENCY_MODE)
+			#define JOYSTICK_POLLING_MS      1
+		#else
+			#define JOYSTICK_POLLING_MS      5
+		#endif
+
+	/* Enums: */
+		/** Bit offsets of the joystick input report fields, see \ref REPORT_LAYOUT_OFFSET. */
+		enum JoystickReportBits_t
+		{
+			JOYSTICK_REPORT_FIELDS(REPORT_LAYOUT_OFFSET)
+			JOYSTICK_REPORT_BITS, /**< Total number of bits in the joystick input report. */
+		};
+
 	/* Function Prototypes: */
 		uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
 		                                    const uint8_t wIndex,
@@ -0,0 +1,56 @@
+/** \file
+ *
+ *  Log2 histograms, small enough to keep latency distributions in RAM for as long as the device
+ *  runs. Values may be added from interrupts.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <string.h>
+#include "LUFA/Common/Common.h"
+#include "Histogram.h"
+
+/** Count a value in its bucket. When the bucket is full, all buckets are halved first, so the
+ *  histogram keeps its shape instead of sticking.
+ *
+ *  \param[in,out] Histogram  Histogram to update
+ *  \param[in]     Value      Value to count
+ */
+void Histogram_Add(Histogram_t* const Histogram, uint16_t Value)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint8_t bucket = 0, i;
+
+	while (Value > 1 && bucket < HISTOGRAM_NUM_BUCKETS - 1) {
+		Value >>= 1;
+		++bucket;
+	}
+
+	GlobalInterruptDisable();
+	if (Histogram->Bucket[bucket] == UINT16_MAX) {
+		for (i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+			Histogram->Bucket[i] >>= 1;
+		}
+	}
+	++Histogram->Bucket[bucket];
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+
+/** Copy the bucket counts of a histogram.
+ *
+ *  \param[in,out] Histogram  Histogram to read
+ *  \param[out]    Buckets    Buffer for \ref HISTOGRAM_NUM_BUCKETS counts, or NULL
+ *  \param[in]     Reset      Clear the histogram after reading
+ */
+void Histogram_Read(Histogram_t* const Histogram, void* const Buckets, const bool Reset)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+
+	GlobalInterruptDisable();
+	if (Buckets != NULL) {
+		memcpy(Buckets, Histogram->Bucket, sizeof(Histogram->Bucket));
+	}
+	if (Reset) {
+		memset(Histogram->Bucket, 0, sizeof(Histogram->Bucket));
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
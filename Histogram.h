@@ -0,0 +1,31 @@
+/** \file
+ *
+ *  Header file for Histogram.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+	/* Macros: */
+		/** Number of buckets in a histogram. Bucket n counts values from 2^n to 2^(n+1) - 1, bucket 0
+		 *  also counts zero, and the last bucket counts everything above.
+		 */
+		#define HISTOGRAM_NUM_BUCKETS        12
+
+	/* Type Defines: */
+		/** Histogram of values in log2 buckets. */
+		typedef struct
+		{
+			uint16_t Bucket[HISTOGRAM_NUM_BUCKETS]; /**< Count of values in each bucket. */
+		} Histogram_t;
+
+	/* Function Prototypes: */
+		void Histogram_Add(Histogram_t* const Histogram, uint16_t Value);
+		void Histogram_Read(Histogram_t* const Histogram, void* const Buckets, const bool Reset);
+
+#endif
@@ -36,11 +36,37 @@
 
 #include <avr/io.h>
 #include <avr/eeprom.h>
-#include <util/delay.h>
 #include "Joystick.h"
 
-/** Buffer to hold the previously generated HID report, for comparison purposes inside the HID class driver. */
-static uint8_t PrevJoystickHIDReportBuffer[sizeof(USB_JoystickReport_Data_t)];
+/** Size of the largest HID report, input or feature. The driver sizes its GetReport buffer from it. */
+#if defined(TRACK_EDGE_LATENCY)
+#define JOYSTICK_REPORT_BUFFER_SIZE MAX(sizeof(USB_JoystickReport_Data_t), \
+                                        MAX(sizeof(USB_JoystickConfigReport_Data_t), sizeof(USB_JoystickStatsReport_Data_t)))
+#else
+#define JOYSTICK_REPORT_BUFFER_SIZE MAX(sizeof(USB_JoystickReport_Data_t), sizeof(USB_JoystickConfigReport_Data_t))
+#endif
+
+/** Double buffer owned by the HID class driver, holding the report ID and the latest published input report.
+ *  Reports are sent from it as published, so no previous report is kept for comparison purposes.
+ */
+static uint8_t JoystickHIDReportBuffers[2][1 + sizeof(USB_JoystickReport_Data_t)];
+
+#if defined(ASYNC_CONTROL_TRANSFERS)
+/** Report ID and report of the HID GetReport or SetReport request in progress, sent or received by the
+ *  driver from the control endpoint interrupt.
+ */
+static uint8_t JoystickHIDControlBuffer[1 + JOYSTICK_REPORT_BUFFER_SIZE];
+#define JOYSTICK_HID_CONTROL_BUFFER JoystickHIDControlBuffer
+#else
+#define JOYSTICK_HID_CONTROL_BUFFER NULL
+#endif
+
+_Static_assert(sizeof(USB_JoystickReport_Data_t) * 8 == JOYSTICK_REPORT_BITS,
+               "Joystick report does not match the report descriptor");
+_Static_assert(sizeof(USB_JoystickConfigReport_Data_t) == JOYSTICK_CONFIG_REPORT_SIZE,
+               "Configuration report does not match the report descriptor");
+_Static_assert(sizeof(USB_JoystickStatsReport_Data_t) == JOYSTICK_STATS_REPORT_SIZE,
+               "Statistics report does not match the report descriptor");
 
 /** LUFA HID Class driver interface configuration and state information. This structure is
  *  passed to all HID Class driver functions, so that multiple instances of the same class
@@ -55,16 +81,17 @@ USB_ClassInfo_HID_Device_t Joystick_HID_Interface =
 					{
 						.Address              = JOYSTICK_EPADDR,
 						.Size                 = JOYSTICK_EPSIZE,
-						.Banks                = 1,
+						.Banks                = 2,
 					},
-				.PrevReportINBuffer           = PrevJoystickHIDReportBuffer,
-				.PrevReportINBufferSize       = sizeof(PrevJoystickHIDReportBuffer),
+				.PrevReportINBuffer           = NULL,
+				.PrevReportINBufferSize       = JOYSTICK_REPORT_BUFFER_SIZE,
+				.ReportINBuffers              = JoystickHIDReportBuffers,
+				.ReportINBufferSize           = sizeof(JoystickHIDReportBuffers[0]),
+				.ControlReportBuffer          = JOYSTICK_HID_CONTROL_BUFFER,
 			},
 	};
 
 /* Button mapping structures: */
-#define NUM_BUTTONS 10
-#define NUM_INPUT 14
 const InputMap_t inputMap[NUM_INPUT] = { { MAP_PORTB, _BV(5) }, { MAP_PORTB, _BV(4) }, {
 		MAP_PORTE, _BV(6) }, { MAP_PORTD, _BV(7) }, { MAP_PORTC, _BV(6) }, {
 		MAP_PORTD, _BV(4) }, { MAP_PORTD, _BV(0) }, { MAP_PORTD, _BV(1) }, {
@@ -73,6 +100,82 @@ const InputMap_t inputMap[NUM_INPUT] = { { MAP_PORTB, _BV(5) }, { MAP_PORTB, _BV
 
 uint8_t buttonOrder[NUM_BUTTONS];
 uint8_t eeprom_buttonOrder[NUM_BUTTONS] EEMEM = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+uint8_t eeprom_socdPolicy EEMEM = SOCD_UP_PRIORITY;
+uint8_t eeprom_turboRate[NUM_BUTTONS] EEMEM = {TURBO_OFF};
+Debounce_Config_t eeprom_debounceConfig EEMEM = {
+	.PressTicks   = DEBOUNCE_PRESS_TICKS,
+	.ReleaseTicks = DEBOUNCE_RELEASE_TICKS,
+	.LockoutTicks = DEBOUNCE_LOCKOUT_TICKS,
+	.Eager        = DEBOUNCE_DEFAULT_EAGER,
+};
+
+/** Configuration written by the host, waiting for ConfigTask() to apply it. */
+static USB_JoystickConfigReport_Data_t pendingConfig;
+static volatile bool configPending;
+
+/** Set when the debounced inputs, turbo phases or configuration changed since the last published report. */
+static volatile bool reportDirty;
+
+/** Direction history of the joystick axes, for SOCD resolution. */
+static Socd_Axis_t socdX, socdY;
+
+/** Button remapping and LED blink state, advanced by MapInputTask(). */
+static struct {
+	MapState_t state; /**< Current step. */
+	uint16_t delayMS; /**< Time left before the current step runs. */
+	uint8_t input; /**< Button being assigned an input. */
+	uint8_t button; /**< Input being tried for that button. */
+	uint8_t count; /**< Step repetitions, such as LED toggles or polls with the input held. */
+	uint8_t newButtonOrder[NUM_BUTTONS]; /**< Map being built. */
+} mapInput;
+
+/** Frames elapsed and not yet seen by MapInputTask(). */
+static volatile uint8_t mapTicks;
+
+/** Report button bits contributed by each nibble of each port, indexed by [MapPort_t][nibble][value].
+ *  Rebuilt from inputMap and buttonOrder by UpdateScanTables() whenever the map changes.
+ */
+static uint16_t buttonTable[MAP_NUM_PORTS][2][16];
+
+/** Mask of the pins used as inputs in each port, indexed by MapPort_t. */
+static uint8_t portMask[MAP_NUM_PORTS];
+
+/** Debounce state of each input port, indexed by MapPort_t. Updated every start of frame. */
+static Debounce_Lane_t debounceLanes[MAP_NUM_PORTS];
+
+#if defined(INPUT_CAPTURE_MODE)
+/* Queue of input edges captured by the pin change interrupts, drained every start of frame: */
+static InputEvent_t captureQueue[CAPTURE_QUEUE_SIZE];
+static volatile uint8_t captureHead; /**< Next slot written by the interrupts. */
+static volatile uint8_t captureTail; /**< Next slot read by InputCaptureDrain(). */
+static uint8_t captureOverflow[MAP_NUM_PORTS]; /**< Pressed pins of edges that did not fit in the queue. */
+#endif
+
+#if defined(SLEEP_SCHEDULER)
+static volatile bool reportPending; /**< Set when the main loop has a report to build and send. */
+#if defined(LATENCY_STATS)
+static uint16_t wakeTimestamp; /**< Timer1 count when the main loop last woke up. */
+static uint32_t asleepTicks; /**< Timer1 ticks spent in idle sleep. */
+static uint32_t awakeTicks; /**< Timer1 ticks spent running the main loop. */
+#endif
+#endif
+
+#if defined(TRACK_EDGE_LATENCY)
+/* Input edge to endpoint bank latency measurement, in Timer1 ticks: */
+static uint16_t edgeTimestamp; /**< Time the oldest unreported edge was first sampled. */
+static bool edgePending; /**< Set while edgeTimestamp holds an edge. */
+static bool edgeAccepted; /**< Set once the pending edge has passed the debouncer. */
+static uint16_t worstLatency; /**< Worst latency seen since the last reset. */
+static uint8_t loadedGeneration; /**< Driver SentGeneration when a loaded report was last accounted. */
+#endif
+
+#if defined(LATENCY_STATS)
+/* Latency histograms, in Timer1 ticks, read through the statistics feature report: */
+static uint16_t sofTimestamp; /**< Time the last start of frame event began. */
+static Histogram_t sofHistogram; /**< Start of frame to new report loaded. */
+static Histogram_t edgeHistogram; /**< Input edge to report loaded. */
+static Histogram_t loopHistogram; /**< Main loop iteration time, not counting sleep. */
+#endif
 
 /** Main program entry point. This routine contains the overall program flow, including initial
  *  setup of all components and the main program loop.
@@ -81,14 +184,185 @@ int main(void)
 {
 	SetupHardware();
 	MapInput();
+	SelectSocdPolicy();
 	GlobalInterruptEnable();
 	for (;;)
 	{
-		HID_Device_USBTask(&Joystick_HID_Interface);
+		#if defined(SLEEP_SCHEDULER)
+		SleepUntilWork();
+		#endif
+		#if defined(LATENCY_STATS)
+		uint16_t loopTimestamp = TCNT1;
+		#endif
+		MapInputTask();
+		ConfigTask();
+		ReportTask();
 		USB_USBTask();
+		#if defined(LATENCY_STATS)
+		Histogram_Add(&loopHistogram, TCNT1 - loopTimestamp);
+		#endif
 	}
 }
 
+/** Build and send the joystick report from the main loop. */
+static inline void ReportTask(void)
+{
+	/* Otherwise reports are built in the start of frame event, and loaded from there or from the endpoint interrupt. */
+	#if !defined(REPORT_FROM_INTERRUPT)
+	#if defined(SLEEP_SCHEDULER)
+	if (!reportPending) {
+		return;
+	}
+	reportPending = false;
+	ReportPublish();
+	HID_Device_USBTask(&Joystick_HID_Interface);
+	#if defined(TRACK_EDGE_LATENCY)
+	LatencyReportLoaded();
+	#endif
+	/* A report left unsent because the endpoint bank was busy is retried from the next start of frame. */
+	#else
+	ReportPublish();
+	HID_Device_USBTask(&Joystick_HID_Interface);
+	#if defined(TRACK_EDGE_LATENCY)
+	LatencyReportLoaded();
+	#endif
+	#endif
+	#endif
+}
+
+/** Mark the published report as stale, so the next call to ReportPublish() builds a new one. */
+static inline void ReportInvalidate(void)
+{
+	reportDirty = true;
+	#if defined(SLEEP_SCHEDULER) && !defined(REPORT_FROM_INTERRUPT)
+	reportPending = true;
+	#endif
+}
+
+/** Build a new joystick report into the driver's double buffer and publish it, if anything changed
+ *  since the last one. The driver then sends it as is, without comparing it to the previous report.
+ */
+static void ReportPublish(void)
+{
+	if (!reportDirty) {
+		return;
+	}
+	reportDirty = false;
+
+	USB_TRACE_ENTER(TRACE_REPORT_CREATE);
+	ReportCreate((USB_JoystickReport_Data_t*)HID_Device_GetPublishBuffer(&Joystick_HID_Interface));
+	USB_TRACE_LEAVE(TRACE_REPORT_CREATE);
+	HID_Device_PublishReport(&Joystick_HID_Interface, HID_REPORTID_Joystick, sizeof(USB_JoystickReport_Data_t), true);
+}
+
+/** Fill a joystick input report from the debounced inputs, and show button presses on the LED.
+ *  Called both from the report path and from HID GetReport requests, which may interrupt it.
+ */
+static void ReportCreate(USB_JoystickReport_Data_t* jsRep)
+{
+	InputSnapshot_t snapshot;
+	uint16_t buttons;
+	uint_reg_t CurrentGlobalInt;
+
+	/* Take all ports at once, so every input in the report comes from the same instant. */
+	InputDebounced(&snapshot);
+
+	/* The SOCD history and the LED are shared by every caller, update them in one go. */
+	CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+
+	jsRep->X = Socd_Resolve(&socdX, SOCD_AXIS_X,
+	                        (SnapshotPressed(&snapshot, MAP_AXIS_LEFT) ? SOCD_NEGATIVE : 0) |
+	                        (SnapshotPressed(&snapshot, MAP_AXIS_RIGHT) ? SOCD_POSITIVE : 0));
+	jsRep->Y = Socd_Resolve(&socdY, SOCD_AXIS_Y,
+	                        (SnapshotPressed(&snapshot, MAP_AXIS_DOWN) ? SOCD_NEGATIVE : 0) |
+	                        (SnapshotPressed(&snapshot, MAP_AXIS_UP) ? SOCD_POSITIVE : 0));
+
+	buttons = SnapshotButtons(&snapshot) & ~TurboOffMask();
+	jsRep->Buttons = buttons;
+	jsRep->Padding = 0;
+
+	/* The LED shows button presses, unless the map input state machine is using it. */
+	if (mapInput.state == MAP_STATE_IDLE) {
+		if (jsRep->Buttons) {
+			LED_on();
+		} else {
+			LED_off();
+		}
+	}
+
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+
+#if defined(SLEEP_SCHEDULER)
+/** Put the MCU to sleep until there is work for the main loop. The start of frame, pin change
+ *  and control endpoint interrupts wake it up. While the bus is suspended the MCU is powered
+ *  down until the USB wake up interrupt. Time spent in the interrupt that ends a sleep is
+ *  counted as asleep.
+ */
+static void SleepUntilWork(void)
+{
+	#if defined(LATENCY_STATS)
+	uint16_t sleepTimestamp;
+	#endif
+	bool suspended = (USB_DeviceState == DEVICE_STATE_Suspended);
+
+	set_sleep_mode(suspended ? SLEEP_MODE_PWR_DOWN : SLEEP_MODE_IDLE);
+
+	GlobalInterruptDisable();
+	if (reportPending && !suspended) {
+		GlobalInterruptEnable();
+		return;
+	}
+	#if defined(DEFERRED_USB_EVENTS)
+	/* USB_USBTask() still has to finish a bus event, possibly waiting for the PLL to lock. */
+	if (USB_Device_HasDeferredEvents()) {
+		GlobalInterruptEnable();
+		return;
+	}
+	#endif
+	#if defined(LATENCY_STATS)
+	sleepTimestamp = TCNT1;
+	#endif
+	sleep_enable();
+	GlobalInterruptEnable();
+	sleep_cpu();
+	sleep_disable();
+
+	#if defined(LATENCY_STATS)
+	/* Timer1 stops in power down, so only idle sleeps are accounted. */
+	if (!suspended) {
+		awakeTicks += (uint16_t)(sleepTimestamp - wakeTimestamp);
+		asleepTicks += (uint16_t)(TCNT1 - sleepTimestamp);
+	}
+	wakeTimestamp = TCNT1;
+	#endif
+}
+
+#if defined(LATENCY_STATS)
+
+/** Time the main loop spent asleep and awake, in Timer1 ticks (4 us at 16 MHz).
+ *
+ *  \param[out] asleep  Ticks spent in idle sleep
+ *  \param[out] awake   Ticks spent running
+ *  \param[in]  reset   Start a new measurement after reading
+ */
+static void SleepStatistics(uint32_t* asleep, uint32_t* awake, bool reset)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+
+	GlobalInterruptDisable();
+	*asleep = asleepTicks;
+	*awake = awakeTicks;
+	if (reset) {
+		asleepTicks = 0;
+		awakeTicks = 0;
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+#endif
+#endif
+
 /** Configures the board hardware and chip peripherals for the demo's functionality. */
 static void SetupHardware(void)
 {
@@ -101,6 +375,17 @@ static void SetupHardware(void)
 
 	/* Hardware Initialization */
 	InputInit();
+	DebounceInit();
+	TurboInit();
+	#if defined(USE_TIMESTAMP_TIMER)
+	TimestampTimerInit();
+	#endif
+	#if defined(INPUT_CAPTURE_MODE)
+	InputCaptureInit();
+	#endif
+	#if defined(TRACE_HOT_PATHS)
+	Trace_Init();
+	#endif
 	USB_Init();
 }
 
@@ -115,64 +400,241 @@ static bool IsMapped(uint8_t button, uint8_t orderMap[])
 	return false;
 }
 
+/** Load the button map, and start remapping if buttons 9 and 10 are held at boot. The remap
+ *  itself runs in MapInputTask(), so the device enumerates and reports meanwhile. It is timed by
+ *  the start of frame event, so it only advances while the host is talking to the device.
+ */
 static void MapInput(void)
 {
-	uint8_t input, button, count;
-	uint8_t newButtonOrder[NUM_BUTTONS];
+	uint8_t input;
 
-	/* Default button mapping. */
+	eeprom_read_block(buttonOrder, eeprom_buttonOrder, NUM_BUTTONS);
 	for (input = 0; input < NUM_BUTTONS; ++input) {
-		buttonOrder[input] = input;
+		if (buttonOrder[input] >= NUM_BUTTONS) {
+			/* Erased or corrupt EEPROM, use the default button mapping. */
+			buttonOrder[input] = input;
+		}
 	}
+	UpdateScanTables();
 	if (!InputPressed(8) || !InputPressed(9)) {
-		/* No remapping, load previous map. */
-		eeprom_read_block(buttonOrder, eeprom_buttonOrder, NUM_BUTTONS);
 		return;
 	}
 
 	/* Will remap buttons. Initialize blank new map. */
 	for (input = 0; input < NUM_BUTTONS; ++input) {
-		newButtonOrder[input] = 0xFF;
+		mapInput.newButtonOrder[input] = 0xFF;
 	}
 	/* Blink slowly to inform the user we are remapping. */
-	for (count = 0; count < 20; ++count) {
-		LED_toggle();
-		_delay_ms(100);
+	mapInput.count = 0;
+	MapInputNext(MAP_STATE_START, 0);
+}
+
+/** Move the map input state machine to a new state after a delay. */
+static inline void MapInputNext(MapState_t state, uint16_t delayMS)
+{
+	mapInput.delayMS = delayMS;
+	mapInput.state = state;
+	if (state == MAP_STATE_IDLE) {
+		/* Pick up the new map, and give the LED back to the report. */
+		ReportInvalidate();
 	}
-	input = 0;
-	while (input < NUM_BUTTONS) {
-		button = 0;
-		count = 0;
+}
+
+/** Advance the map input state machine by the time elapsed since the last call, as counted by the
+ *  start of frame event. Should be called from the main loop.
+ */
+static void MapInputTask(void)
+{
+	uint_reg_t CurrentGlobalInt;
+	uint8_t elapsed;
+
+	if (mapInput.state == MAP_STATE_IDLE) {
+		return;
+	}
+
+	CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+	elapsed = mapTicks;
+	mapTicks = 0;
+	SetGlobalInterruptMask(CurrentGlobalInt);
+
+	if (mapInput.delayMS > elapsed) {
+		mapInput.delayMS -= elapsed;
+		return;
+	}
+
+	switch (mapInput.state) {
+	case MAP_STATE_START:
+		LED_toggle();
+		if (++mapInput.count < 20) {
+			MapInputNext(MAP_STATE_START, 100);
+			break;
+		}
+		mapInput.input = 0;
+		mapInput.button = 0;
+		mapInput.count = 0;
+		MapInputNext(MAP_STATE_SCAN, 150);
+		break;
+	case MAP_STATE_SCAN:
 		/*
 		 * Cycle through inputs and see if it keeps pressed for
 		 * one second. Can't map the same input to another button.
 		 */
-		while (count < 20) {
-			++count;
-			_delay_ms(50);
-			if (InputPressed(button) && !IsMapped(button, newButtonOrder)) {
-				LED_on();
-			} else {
-				LED_toggle();
-				count = 0;
-				++button;
-				if (button >= NUM_BUTTONS) {
-					button = 0;
-				}
+		if (InputPressed(mapInput.button) && !IsMapped(mapInput.button, mapInput.newButtonOrder)) {
+			LED_on();
+			if (++mapInput.count >= 20) {
+				/* Found the new input for this button. */
+				LED_off();
+				MapInputNext(MAP_STATE_CONFIRM, 1000);
+				break;
+			}
+		} else {
+			LED_toggle();
+			mapInput.count = 0;
+			++mapInput.button;
+			if (mapInput.button >= NUM_BUTTONS) {
+				mapInput.button = 0;
 			}
 		}
-		/* Found the new input for this button. */
+		MapInputNext(MAP_STATE_SCAN, 50);
+		break;
+	case MAP_STATE_CONFIRM:
+		mapInput.newButtonOrder[mapInput.input] = mapInput.button;
+		if (++mapInput.input < NUM_BUTTONS) {
+			mapInput.button = 0;
+			mapInput.count = 0;
+			MapInputNext(MAP_STATE_SCAN, 50);
+			break;
+		}
+		/* Done remapping. Use the new map and save the bytes that changed to eeprom. */
+		memcpy(buttonOrder, mapInput.newButtonOrder, NUM_BUTTONS);
+		UpdateScanTables();
+		eeprom_update_block(buttonOrder, eeprom_buttonOrder, NUM_BUTTONS);
 		LED_off();
-		_delay_ms(1000);
-		newButtonOrder[input] = button;
-		++input;
+		MapInputNext(MAP_STATE_IDLE, 0);
+		break;
+	case MAP_STATE_BLINK:
+		if (mapInput.count & 1) {
+			LED_off();
+		} else {
+			LED_on();
+		}
+		if (--mapInput.count) {
+			MapInputNext(MAP_STATE_BLINK, 200);
+		} else {
+			MapInputNext(MAP_STATE_IDLE, 0);
+		}
+		break;
+	default:
+		break;
 	}
-	/* Done remapping. Use the new map and save to eeprom. */
-	LED_off();
-	for (input = 0; input < NUM_BUTTONS; ++input) {
-		buttonOrder[input] = newButtonOrder[input];
+}
+
+/** Load the SOCD policy, or select a new one if button 9 is held alone at boot together with a
+ *  direction: left for neutral, right for last input wins, down for first input wins and up for
+ *  up priority. The LED blinks once per policy number to confirm the selection.
+ */
+static void SelectSocdPolicy(void)
+{
+	uint8_t policy, selected;
+
+	policy = eeprom_read_byte(&eeprom_socdPolicy);
+	if (InputPressed(8) && !InputPressed(9)) {
+		selected = SOCD_NUM_POLICIES;
+		if (InputPressed(MAP_AXIS_LEFT)) {
+			selected = SOCD_NEUTRAL;
+		} else if (InputPressed(MAP_AXIS_RIGHT)) {
+			selected = SOCD_LAST_WINS;
+		} else if (InputPressed(MAP_AXIS_DOWN)) {
+			selected = SOCD_FIRST_WINS;
+		} else if (InputPressed(MAP_AXIS_UP)) {
+			selected = SOCD_UP_PRIORITY;
+		}
+		if (selected < SOCD_NUM_POLICIES) {
+			policy = selected;
+			eeprom_update_byte(&eeprom_socdPolicy, policy);
+			mapInput.count = (policy + 1) * 2;
+			MapInputNext(MAP_STATE_BLINK, 0);
+		}
+	}
+	/* Unknown values, such as erased EEPROM, keep the default policy. */
+	Socd_SetPolicy(policy);
+}
+
+/** Fill the configuration feature report with the current settings. */
+static void ConfigReportCreate(USB_JoystickConfigReport_Data_t* config)
+{
+	Debounce_Config_t debounce;
+
+	Debounce_GetConfig(&debounce);
+
+	config->Version = CONFIG_REPORT_VERSION;
+	config->Flags = 0;
+	memcpy(config->ButtonOrder, buttonOrder, NUM_BUTTONS);
+	Turbo_GetRates(config->TurboRate, NUM_BUTTONS);
+	config->SocdPolicy = Socd_GetPolicy();
+	config->DebouncePressTicks = debounce.PressTicks;
+	config->DebounceReleaseTicks = debounce.ReleaseTicks;
+	config->DebounceLockoutTicks = debounce.LockoutTicks;
+	config->DebounceEager = debounce.Eager;
+	config->PollingIntervalMS = JOYSTICK_POLLING_MS;
+}
+
+/** Check a configuration written by the host. The button order must use every input once. */
+static bool ConfigReportValid(const USB_JoystickConfigReport_Data_t* config)
+{
+	uint16_t used = 0;
+	uint8_t i;
+
+	if (config->Version != CONFIG_REPORT_VERSION || config->SocdPolicy >= SOCD_NUM_POLICIES) {
+		return false;
+	}
+	for (i = 0; i < NUM_BUTTONS; ++i) {
+		if (config->ButtonOrder[i] >= NUM_BUTTONS || config->TurboRate[i] > TURBO_NUM_RATES) {
+			return false;
+		}
+		used |= (1 << config->ButtonOrder[i]);
+	}
+	return used == (1 << NUM_BUTTONS) - 1;
+}
+
+/** Apply a configuration written by the host. All settings change together with interrupts
+ *  masked, so no frame or report sees half of them. Should be called from the main loop.
+ */
+static void ConfigTask(void)
+{
+	USB_JoystickConfigReport_Data_t config;
+	Debounce_Config_t debounce;
+	uint_reg_t CurrentGlobalInt;
+
+	if (!configPending) {
+		return;
+	}
+
+	CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+	config = pendingConfig;
+	configPending = false;
+
+	debounce.PressTicks = config.DebouncePressTicks;
+	debounce.ReleaseTicks = config.DebounceReleaseTicks;
+	debounce.LockoutTicks = config.DebounceLockoutTicks;
+	debounce.Eager = (config.DebounceEager != 0);
+
+	memcpy(buttonOrder, config.ButtonOrder, NUM_BUTTONS);
+	UpdateScanTables();
+	Turbo_SetRates(config.TurboRate, NUM_BUTTONS);
+	Socd_SetPolicy(config.SocdPolicy);
+	Debounce_SetConfig(&debounce);
+	ReportInvalidate();
+	SetGlobalInterruptMask(CurrentGlobalInt);
+
+	if (config.Flags & CONFIG_FLAG_SAVE) {
+		eeprom_update_block(buttonOrder, eeprom_buttonOrder, NUM_BUTTONS);
+		eeprom_update_block(config.TurboRate, eeprom_turboRate, NUM_BUTTONS);
+		eeprom_update_byte(&eeprom_socdPolicy, config.SocdPolicy);
+		eeprom_update_block(&debounce, &eeprom_debounceConfig, sizeof(debounce));
 	}
-	eeprom_write_block(buttonOrder, eeprom_buttonOrder, NUM_BUTTONS);
 }
 
 /** Configure joystick and button pins. */
@@ -203,27 +665,376 @@ static void InputInit(void)
 			DDRE &= ~map.mask;
 			PORTE |= map.mask;
 		}
+		portMask[map.port] |= map.mask;
 	}
 }
 
-static bool InputPressed(uint8_t input) {
+/** Regenerate the pin to report bit tables from inputMap and the current buttonOrder. */
+static void UpdateScanTables(void)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint16_t pinButtons[MAP_NUM_PORTS][8];
+	InputMap_t map;
+	uint8_t port, nibble, value, bit, i;
+
+	/* Report bits of each pin, then each table entry is the entry with its lowest bit cleared
+	 * plus that bit's buttons. This is quick enough to swap the tables while reports are built. */
+	memset(pinButtons, 0, sizeof(pinButtons));
+	for (i = 0; i < NUM_BUTTONS; ++i) {
+		map = inputMap[buttonOrder[i]];
+		for (bit = 0; bit < 8; ++bit) {
+			if (map.mask & (1 << bit)) {
+				pinButtons[map.port][bit] |= (1 << i);
+			}
+		}
+	}
+
+	GlobalInterruptDisable();
+	for (port = 0; port < MAP_NUM_PORTS; ++port) {
+		for (nibble = 0; nibble < 2; ++nibble) {
+			buttonTable[port][nibble][0] = 0;
+			for (value = 1; value < 16; ++value) {
+				for (bit = 0; !(value & (1 << bit)); ++bit);
+				buttonTable[port][nibble][value] = buttonTable[port][nibble][value & (value - 1)] |
+				                                   pinButtons[port][nibble * 4 + bit];
+			}
+		}
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+
+/** Latch all input ports at once. Pressed inputs read as set bits, unused pins are cleared. */
+static inline void InputScan(InputSnapshot_t* snapshot)
+{
+	snapshot->port[MAP_PORTB] = ~PINB & portMask[MAP_PORTB];
+	snapshot->port[MAP_PORTC] = ~PINC & portMask[MAP_PORTC];
+	snapshot->port[MAP_PORTD] = ~PIND & portMask[MAP_PORTD];
+	snapshot->port[MAP_PORTE] = ~PINE & portMask[MAP_PORTE];
+}
+
+/** Load the debounce settings. */
+static void DebounceInit(void)
+{
+	Debounce_Config_t config;
+
+	eeprom_read_block(&config, &eeprom_debounceConfig, sizeof(config));
+	if (config.PressTicks == 0xFF) {
+		/* Erased EEPROM, use the defaults. */
+		config.PressTicks = DEBOUNCE_PRESS_TICKS;
+		config.ReleaseTicks = DEBOUNCE_RELEASE_TICKS;
+		config.LockoutTicks = DEBOUNCE_LOCKOUT_TICKS;
+		config.Eager = DEBOUNCE_DEFAULT_EAGER;
+	}
+	Debounce_SetConfig(&config);
+}
+
+/** Load the turbo rate of each button. */
+static void TurboInit(void)
+{
+	uint8_t rates[NUM_BUTTONS];
+
+	eeprom_read_block(rates, eeprom_turboRate, NUM_BUTTONS);
+	Turbo_SetRates(rates, NUM_BUTTONS);
+}
+
+/** Buttons to report as released because of turbo, read atomically from the frame tick. */
+static inline uint16_t TurboOffMask(void)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint16_t mask;
+
+	GlobalInterruptDisable();
+	mask = Turbo_GetOffMask();
+	SetGlobalInterruptMask(CurrentGlobalInt);
+	return mask;
+}
+
+/** Sample all ports and advance their debounce counters. Called once per start of frame.
+ *
+ *  \return Boolean \c true if the debounced state of any input changed
+ */
+static inline bool InputDebounceTick(void)
+{
+	InputSnapshot_t raw;
+	uint8_t port, previous;
+	uint8_t changed = 0, pending = 0;
+	#if defined(TRACK_EDGE_LATENCY) || defined(INPUT_CAPTURE_MODE)
+	uint16_t timestamp = TCNT1;
+	#endif
+
+	InputScan(&raw);
+	#if defined(INPUT_CAPTURE_MODE)
+	InputCaptureDrain(&raw, &timestamp);
+	#endif
+	for (port = 0; port < MAP_NUM_PORTS; ++port) {
+		previous = debounceLanes[port].State;
+		Debounce_Update(&debounceLanes[port], raw.port[port]);
+		changed |= previous ^ debounceLanes[port].State;
+		pending |= raw.port[port] ^ debounceLanes[port].State;
+	}
+
+	#if defined(TRACK_EDGE_LATENCY)
+	LatencyTrackEdges(changed, pending, timestamp);
+	#endif
+	return changed;
+}
+
+/** Copy the debounced state of all ports into a snapshot. */
+static inline void InputDebounced(InputSnapshot_t* snapshot)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint8_t port;
+
+	GlobalInterruptDisable();
+	for (port = 0; port < MAP_NUM_PORTS; ++port) {
+		snapshot->port[port] = debounceLanes[port].State;
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+
+#if defined(USE_TIMESTAMP_TIMER)
+/** Start Timer1 free running at F_CPU/64 (4 us per tick at 16 MHz), used to timestamp input edges. */
+static void TimestampTimerInit(void)
+{
+	TCCR1A = 0;
+	TCCR1B = (1 << CS11) | (1 << CS10);
+}
+#endif
+
+#if defined(INPUT_CAPTURE_MODE)
+/** Arm the edge interrupts available for the pins in inputMap. PORTB pins use PCINT0-7, PD0-3
+ *  use INT0-3 and PE6 uses INT6. The remaining pins (PC6, PD4-7) have no edge interrupt on the
+ *  ATmega32U4 and are only sampled at the start of frame.
+ */
+static void InputCaptureInit(void)
+{
+	InputMap_t map;
+	uint8_t i, bit;
+
+	for (i = 0; i < NUM_INPUT; ++i) {
+		map = inputMap[i];
+		switch (map.port) {
+		case MAP_PORTB:
+			PCMSK0 |= map.mask;
+			break;
+		case MAP_PORTD:
+			for (bit = 0; bit < 4; ++bit) {
+				if (map.mask & (1 << bit)) {
+					EICRA |= (1 << (bit * 2)); // Any edge
+					EIMSK |= (1 << bit);
+				}
+			}
+			break;
+		case MAP_PORTE:
+			if (map.mask & (1 << PE6)) {
+				EICRB |= (1 << ISC60); // Any edge
+				EIMSK |= (1 << INT6);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	EIFR = 0xFF;
+	PCIFR = (1 << PCIF0);
+	if (PCMSK0) {
+		PCICR |= (1 << PCIE0);
+	}
+}
+
+/** Queue an edge seen on a port. Called from the pin change interrupts only. */
+static inline void InputCapture(MapPort_t port, uint8_t pins)
+{
+	uint8_t head = captureHead;
+	uint8_t next = (head + 1) & (CAPTURE_QUEUE_SIZE - 1);
+	uint8_t pressed = ~pins & portMask[port];
+
+	if (next == captureTail) {
+		/* Queue full, keep the presses without a timestamp. */
+		captureOverflow[port] |= pressed;
+		return;
+	}
+	captureQueue[head].timestamp = TCNT1;
+	captureQueue[head].port = port;
+	captureQueue[head].pressed = pressed;
+	captureHead = next;
+}
+
+/** Merge the queued edges into a snapshot, so presses shorter than a frame are still seen.
+ *
+ *  \param[in,out] snapshot   Snapshot taken at this start of frame
+ *  \param[in,out] timestamp  Sample time, replaced by the time of the oldest queued edge if any
+ */
+static inline void InputCaptureDrain(InputSnapshot_t* snapshot, uint16_t* timestamp)
+{
+	uint8_t tail = captureTail;
+	uint8_t port;
+
+	if (tail != captureHead) {
+		*timestamp = captureQueue[tail].timestamp;
+	}
+	while (tail != captureHead) {
+		snapshot->port[captureQueue[tail].port] |= captureQueue[tail].pressed;
+		tail = (tail + 1) & (CAPTURE_QUEUE_SIZE - 1);
+	}
+	captureTail = tail;
+
+	for (port = 0; port < MAP_NUM_PORTS; ++port) {
+		snapshot->port[port] |= captureOverflow[port];
+		captureOverflow[port] = 0;
+	}
+}
+
+ISR(PCINT0_vect)
+{
+	InputCapture(MAP_PORTB, PINB);
+}
+
+ISR(INT0_vect)
+{
+	InputCapture(MAP_PORTD, PIND);
+}
+ISR(INT1_vect, ISR_ALIASOF(INT0_vect));
+ISR(INT2_vect, ISR_ALIASOF(INT0_vect));
+ISR(INT3_vect, ISR_ALIASOF(INT0_vect));
+
+ISR(INT6_vect)
+{
+	InputCapture(MAP_PORTE, PINE);
+}
+#endif
+
+#if defined(TRACK_EDGE_LATENCY)
+/** Note the time of the oldest input edge not yet loaded into the endpoint bank. Without input
+ *  capture, edges are seen at the start of frame sampling, so the true pin edge may be up to
+ *  one frame earlier.
+ *
+ *  \param[in] changed    Inputs whose debounced state changed in this tick
+ *  \param[in] pending    Inputs whose raw sample still differs from the debounced state
+ *  \param[in] timestamp  Time the inputs were sampled or captured
+ */
+static inline void LatencyTrackEdges(uint8_t changed, uint8_t pending, uint16_t timestamp)
+{
+	if (!edgePending && (changed || pending)) {
+		edgeTimestamp = timestamp;
+		edgePending = true;
+	}
+	if (changed) {
+		edgeAccepted = true;
+	} else if (!pending && !edgeAccepted) {
+		/* Bounce rejected by the debouncer, nothing will be reported. */
+		edgePending = false;
+	}
+}
+
+/** Account the latency of an accepted edge once a new report has been loaded into the endpoint bank.
+ *  Should be called after every call that may load one.
+ */
+static inline void LatencyReportLoaded(void)
+{
+	uint16_t now = TCNT1;
+	uint16_t latency;
+
+	if (loadedGeneration == Joystick_HID_Interface.State.SentGeneration) {
+		return;
+	}
+	loadedGeneration = Joystick_HID_Interface.State.SentGeneration;
+	#if defined(LATENCY_STATS)
+	Histogram_Add(&sofHistogram, now - sofTimestamp);
+	#endif
+	if (!edgeAccepted) {
+		return;
+	}
+	latency = now - edgeTimestamp;
+	if (latency > worstLatency) {
+		worstLatency = latency;
+	}
+	#if defined(LATENCY_STATS)
+	Histogram_Add(&edgeHistogram, latency);
+	#endif
+	edgePending = false;
+	edgeAccepted = false;
+}
+
+/** Worst input edge to endpoint bank loaded latency seen, in Timer1 ticks (4 us at 16 MHz).
+ *
+ *  \param[in] reset  Start a new measurement after reading
+ *
+ *  \return Worst latency since the last reset
+ */
+static uint16_t LatencyWorstCase(bool reset)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint16_t latency;
+
+	GlobalInterruptDisable();
+	latency = worstLatency;
+	if (reset) {
+		worstLatency = 0;
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+	return latency;
+}
+
+/** Fill the statistics feature report from the worst latency and, with LATENCY_STATS, the
+ *  histograms and counters, which read as zero otherwise.
+ *
+ *  \param[out] stats  Report to fill
+ */
+static void StatsReportCreate(USB_JoystickStatsReport_Data_t* stats)
+{
+	uint32_t asleep = 0, awake = 0;
+
+	memset(stats, 0, sizeof(USB_JoystickStatsReport_Data_t));
+	stats->Version = STATS_REPORT_VERSION;
+	stats->TickMicroseconds = 64 / (F_CPU / 1000000);
+	#if defined(LATENCY_STATS)
+	Histogram_Read(&sofHistogram, &stats->SofToReport, false);
+	Histogram_Read(&edgeHistogram, &stats->EdgeToReport, false);
+	Histogram_Read(&loopHistogram, &stats->LoopTime, false);
+	#endif
+	stats->WorstEdgeToReport = LatencyWorstCase(false);
+	#if defined(SLEEP_SCHEDULER) && defined(LATENCY_STATS)
+	SleepStatistics(&asleep, &awake, false);
+	#endif
+	stats->AsleepTicks = asleep;
+	stats->AwakeTicks = awake;
+}
+#endif
+
+/** Translate a snapshot into the report button mask, one table lookup per port nibble. */
+static inline uint16_t SnapshotButtons(const InputSnapshot_t* snapshot)
+{
+	uint16_t buttons = 0;
+	uint8_t port, pins;
+
+	for (port = 0; port < MAP_NUM_PORTS; ++port) {
+		pins = snapshot->port[port];
+		buttons |= buttonTable[port][0][pins & 0x0F];
+		buttons |= buttonTable[port][1][pins >> 4];
+	}
+	return buttons;
+}
+
+/** Check if an input is pressed in a previously latched snapshot. Buttons go through buttonOrder. */
+static inline bool SnapshotPressed(const InputSnapshot_t* snapshot, uint8_t input)
+{
 	InputMap_t map;
 	if (input < NUM_BUTTONS) {
-		input = buttonOrder[input];
+		return (SnapshotButtons(snapshot) >> input) & 1;
 	}
 	map = inputMap[input];
-	switch (map.port) {
-	case MAP_PORTB:
-		return ~PINB & map.mask;
-	case MAP_PORTC:
-		return ~PINC & map.mask;
-	case MAP_PORTD:
-		return ~PIND & map.mask;
-	case MAP_PORTE:
-		return ~PINE & map.mask;
-	}
-	return false;
+	return snapshot->port[map.port] & map.mask;
+}
 
+/** Check if a raw input of inputMap is pressed right now, regardless of buttonOrder. */
+static bool InputPressed(uint8_t input) {
+	InputMap_t map = inputMap[input];
+	InputSnapshot_t snapshot;
+
+	InputScan(&snapshot);
+	return snapshot.port[map.port] & map.mask;
 }
 
 static inline void LED_on(void)
@@ -263,20 +1074,86 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 	ConfigSuccess &= HID_Device_ConfigureEndpoints(&Joystick_HID_Interface);
 
 	USB_Device_EnableSOFEvents();
+
+	/* Configuring the endpoints dropped the published report. */
+	ReportInvalidate();
+}
+
+/** Event handler for the library USB Suspend event. The main loop powers the MCU down while suspended. */
+void EVENT_USB_Device_Suspend(void)
+{
+	LED_off();
 }
 
 /** Event handler for the library USB Control Request reception event. */
 void EVENT_USB_Device_ControlRequest(void)
 {
 	HID_Device_ProcessControlRequest(&Joystick_HID_Interface);
+	#if defined(TRACE_HOT_PATHS)
+	Trace_ProcessControlRequest();
+	#endif
 }
 
 /** Event handler for the USB device Start Of Frame event. */
 void EVENT_USB_Device_StartOfFrame(void)
 {
+	#if defined(LATENCY_STATS)
+	sofTimestamp = TCNT1;
+	#endif
 	HID_Device_MillisecondElapsed(&Joystick_HID_Interface);
+
+	if (mapInput.state != MAP_STATE_IDLE && mapTicks < 0xFF) {
+		++mapTicks;
+	}
+
+	InputSnapshot_t snapshot;
+	bool changed = InputDebounceTick();
+	InputDebounced(&snapshot);
+	changed |= Turbo_Tick(USB_Device_GetFrameNumber(), SnapshotButtons(&snapshot));
+	if (changed) {
+		ReportInvalidate();
+	}
+
+	#if defined(SLEEP_SCHEDULER) && !defined(REPORT_FROM_INTERRUPT)
+	/* Otherwise wake the main loop only if a published report is still waiting for a free bank, or the
+	 * idle period is over. */
+	if (Joystick_HID_Interface.State.PublishedGeneration != Joystick_HID_Interface.State.SentGeneration ||
+	    (Joystick_HID_Interface.State.IdleCount && !Joystick_HID_Interface.State.IdleMSRemaining)) {
+		reportPending = true;
+	}
+	#endif
+
+	#if defined(REPORT_FROM_INTERRUPT)
+	ReportPublish();
+	#endif
+
+	#if defined(LOW_LATENCY_MODE) && !defined(INTERRUPT_HID_ENDPOINT)
+	/* Load the report built from this frame's samples, ready for the host's IN token. */
+	uint8_t PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
+	HID_Device_USBTask(&Joystick_HID_Interface);
+	Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+	#endif
+
+	#if defined(TRACK_EDGE_LATENCY) && defined(REPORT_FROM_INTERRUPT)
+	/* Publishing may also load the report straight away when the endpoint bank is free. */
+	LatencyReportLoaded();
+	#endif
 }
 
+#if defined(INTERRUPT_HID_ENDPOINT)
+/** Event handler for the library USB endpoint interrupt event. Loads the next report as soon as the host
+ *  has taken the previous one, regardless of what the main loop is doing.
+ */
+void EVENT_USB_Device_EndpointInterrupt(const uint8_t EndpointMask)
+{
+	HID_Device_ProcessEndpointInterrupt(&Joystick_HID_Interface, EndpointMask);
+
+	#if defined(TRACK_EDGE_LATENCY)
+	LatencyReportLoaded();
+	#endif
+}
+#endif
+
 /** HID class driver callback function for the creation of HID reports to the host.
  *
  *  \param[in]     HIDInterfaceInfo  Pointer to the HID class interface configuration structure being referenced
@@ -293,48 +1170,25 @@ bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDIn
                                          void* ReportData,
                                          uint16_t* const ReportSize)
 {
-	USB_JoystickReport_Data_t* jsRep = (USB_JoystickReport_Data_t*)ReportData;
-
-	if (InputPressed(MAP_AXIS_LEFT)) {
-		jsRep->X = 0;
-	}
-	else if (InputPressed(MAP_AXIS_RIGHT)) {
-		jsRep->X = 255;
-	}
-	else {
-		jsRep->X = 128;
-	}
-
-	if (InputPressed(MAP_AXIS_DOWN)) {
-		jsRep->Y = 0;
-	}
-	else if (InputPressed(MAP_AXIS_UP)) {
-		jsRep->Y = 255;
-	}
-	else {
-		jsRep->Y = 128;
-	}
-
-	jsRep->ButtonL = 0x00;
-	jsRep->ButtonL |= InputPressed(0) << 0;
-	jsRep->ButtonL |= InputPressed(1) << 1;
-	jsRep->ButtonL |= InputPressed(2) << 2;
-	jsRep->ButtonL |= InputPressed(3) << 3;
-	jsRep->ButtonL |= InputPressed(4) << 4;
-	jsRep->ButtonL |= InputPressed(5) << 5;
-	jsRep->ButtonL |= InputPressed(6) << 6;
-	jsRep->ButtonL |= InputPressed(7) << 7;
-
-	jsRep->ButtonH = 0x00;
-	jsRep->ButtonH |= InputPressed(8) << 0;
-	jsRep->ButtonH |= InputPressed(9) << 1;
-
-	if (jsRep->ButtonL || jsRep->ButtonH) {
-		LED_on();
-	} else {
-		LED_off();
+	if (ReportType == HID_REPORT_ITEM_Feature) {
+		switch (*ReportID) {
+		case HID_REPORTID_Config:
+			ConfigReportCreate((USB_JoystickConfigReport_Data_t*)ReportData);
+			*ReportSize = sizeof(USB_JoystickConfigReport_Data_t);
+			break;
+		#if defined(TRACK_EDGE_LATENCY)
+		case HID_REPORTID_Stats:
+			StatsReportCreate((USB_JoystickStatsReport_Data_t*)ReportData);
+			*ReportSize = sizeof(USB_JoystickStatsReport_Data_t);
+			break;
+		#endif
+		}
+		return false;
 	}
 
+	/* Input reports are published to the driver by ReportPublish(), this only answers GetReport requests. */
+	*ReportID = HID_REPORTID_Joystick;
+	ReportCreate((USB_JoystickReport_Data_t*)ReportData);
 	*ReportSize = sizeof(USB_JoystickReport_Data_t);
 	return false;
 }
@@ -353,6 +1207,31 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
                                           const void* ReportData,
                                           const uint16_t ReportSize)
 {
-	// Unused (but mandatory for the HID class driver) in this demo, since there are no Host->Device reports
+	const USB_JoystickConfigReport_Data_t* config = (const USB_JoystickConfigReport_Data_t*)ReportData;
+
+	#if defined(TRACK_EDGE_LATENCY)
+	if (ReportType == HID_REPORT_ITEM_Feature && ReportID == HID_REPORTID_Stats) {
+		#if defined(LATENCY_STATS)
+		Histogram_Read(&sofHistogram, NULL, true);
+		Histogram_Read(&edgeHistogram, NULL, true);
+		Histogram_Read(&loopHistogram, NULL, true);
+		#endif
+		LatencyWorstCase(true);
+		#if defined(SLEEP_SCHEDULER) && defined(LATENCY_STATS)
+		uint32_t asleep, awake;
+		SleepStatistics(&asleep, &awake, true);
+		#endif
+		return;
+	}
+	#endif
+
+	if (ReportType != HID_REPORT_ITEM_Feature || ReportID != HID_REPORTID_Config ||
+	    ReportSize != sizeof(USB_JoystickConfigReport_Data_t) || !ConfigReportValid(config)) {
+		return;
+	}
+
+	/* Applied by ConfigTask(), between two frames. */
+	pendingConfig = *config;
+	configPending = true;
 }
 
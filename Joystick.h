@@ -43,29 +43,114 @@
 		#include <avr/wdt.h>
 		#include <avr/power.h>
 		#include <avr/interrupt.h>
+		#include <avr/sleep.h>
 		#include <string.h>
 
 		#include "LUFA/Drivers/USB/USB.h"
 		#include "Descriptors.h"
+		#include "Debounce.h"
+		#include "Socd.h"
+		#include "Turbo.h"
+		#include "Trace.h"
+		#include "Histogram.h"
 
+	/* Macros: */
+		/** Number of joystick buttons, and of inputs including the four directions. */
+		#define NUM_BUTTONS 10
+		#define NUM_INPUT 14
+
+		/** Version of the configuration feature report layout. */
+		#define CONFIG_REPORT_VERSION 1
+
+		/** Version of the latency statistics feature report layout. */
+		#define STATS_REPORT_VERSION 2
+
+		/** USB_JoystickConfigReport_Data_t flag: also save the configuration to EEPROM. */
+		#define CONFIG_FLAG_SAVE (1 << 0)
+
+		/** Number of ports in MapPort_t. */
+		#define MAP_NUM_PORTS 4
+
+		/** Trace point around the joystick report build in ReportPublish(), with TRACE_HOT_PATHS. */
+		#define TRACE_REPORT_CREATE USB_TRACE_APPLICATION
+
+		/** Number of captured input edges that can wait for the next start of frame. Must be a power of two. */
+		#define CAPTURE_QUEUE_SIZE 16
+
+		/** Debounce mode used unless changed by the host. Input capture defaults to eager, since captured
+		 *  presses shorter than the press window would be filtered out otherwise.
+		 */
+		#if defined(INPUT_CAPTURE_MODE)
+			#define DEBOUNCE_DEFAULT_EAGER true
+		#else
+			#define DEBOUNCE_DEFAULT_EAGER false
+		#endif
+
+		/** Timer1 runs free as a timestamp clock when edges are timed. */
+		#if defined(LOW_LATENCY_MODE) || defined(INPUT_CAPTURE_MODE) || defined(SLEEP_SCHEDULER) || defined(LATENCY_STATS)
+			#define USE_TIMESTAMP_TIMER
+		#endif
+
+		/** Input edges are timed until the report holding them is loaded into the endpoint bank. */
+		#if defined(LOW_LATENCY_MODE) || defined(LATENCY_STATS)
+			#define TRACK_EDGE_LATENCY
+		#endif
+
+		/** Reports are built and loaded from interrupts rather than from the main loop, so main loop work
+		 *  such as EEPROM writes cannot delay them.
+		 */
+		#if defined(LOW_LATENCY_MODE) || defined(INTERRUPT_HID_ENDPOINT)
+			#define REPORT_FROM_INTERRUPT
+		#endif
+
+	/* Preprocessor Checks: */
+		#if defined(SLEEP_SCHEDULER) && !defined(INTERRUPT_CONTROL_ENDPOINT)
+			#error SLEEP_SCHEDULER requires INTERRUPT_CONTROL_ENDPOINT, so control requests wake the MCU up.
+		#endif
 
 /* Type Defines: */
 		/** Type define for the joystick HID report structure, for creating and sending HID reports to the host PC.
-		 *  This mirrors the layout described to the host in the HID report descriptor, in Descriptors.c.
-		 *
-\		 *     B08 B07 B06 B05 B04 B03 B02 B01 .... Two bytes with buttons plus padding.
-		 *       .   .   .   .   .   . B10 B09
-		 *      X7  X6  X5  X4  X3  X2  X1  X0 .... 8 bit signed relative coordinate x.
-		 *      Y7  Y6  Y5  Y4  Y3  Y2  Y1  Y0 .... 8 bit signed relative coordinate y.
-		 *
-		 **/
+		 *  Generated from JOYSTICK_REPORT_FIELDS in Descriptors.h, like the HID report descriptor.
+		 */
 		typedef struct
 		{
-			uint8_t ButtonL; /**< Bit mask of the currently pressed joystick buttons */
-			uint8_t ButtonH; /**< Bit mask of the currently pressed joystick buttons */
-			uint8_t  X; /**< Current absolute joystick X position, as a signed 8-bit integer */
-			uint8_t  Y; /**< Current absolute joystick Y position, as a signed 8-bit integer */
-		} USB_JoystickReport_Data_t;
+			JOYSTICK_REPORT_FIELDS(REPORT_LAYOUT_MEMBER)
+		} ATTR_PACKED USB_JoystickReport_Data_t;
+
+		/** Type define for the vendor feature report used to read and change the device configuration
+		 *  at runtime, through HID GetReport and SetReport requests. Written settings are applied
+		 *  between two frames, and saved to EEPROM if \ref CONFIG_FLAG_SAVE is set.
+		 */
+		typedef struct
+		{
+			uint8_t Version; /**< Layout version, \ref CONFIG_REPORT_VERSION. Reports with another version are ignored. */
+			uint8_t Flags; /**< CONFIG_FLAG_* mask, only used when written. */
+			uint8_t ButtonOrder[NUM_BUTTONS]; /**< Input of each button, must be a permutation of the buttons. */
+			uint8_t TurboRate[NUM_BUTTONS]; /**< Turbo_Rate_t of each button. */
+			uint8_t SocdPolicy; /**< Socd_Policy_t of the directions. */
+			uint8_t DebouncePressTicks; /**< Debounce press window in milliseconds. */
+			uint8_t DebounceReleaseTicks; /**< Debounce release window in milliseconds. */
+			uint8_t DebounceLockoutTicks; /**< Eager debounce lockout in milliseconds. */
+			uint8_t DebounceEager; /**< Non-zero for eager debouncing. */
+			uint8_t PollingIntervalMS; /**< Endpoint polling interval, read only as it needs re-enumeration. */
+		} ATTR_PACKED USB_JoystickConfigReport_Data_t;
+
+		/** Type define for the vendor feature report holding the latency histograms and counters, read with HID
+		 *  GetReport requests. Any SetReport request on it clears them. Values are little endian, histogram counts
+		 *  are in the log2 buckets of Histogram_t, and times in Timer1 ticks. The report exists whenever input edges
+		 *  are timed, but only the worst latency is kept without LATENCY_STATS; the histograms and counters read as zero.
+		 */
+		typedef struct
+		{
+			uint8_t Version; /**< Layout version, \ref STATS_REPORT_VERSION. */
+			uint8_t TickMicroseconds; /**< Length of a Timer1 tick in microseconds. */
+			uint16_t SofToReport[HISTOGRAM_NUM_BUCKETS]; /**< Start of frame to new report loaded into the endpoint bank. */
+			uint16_t EdgeToReport[HISTOGRAM_NUM_BUCKETS]; /**< Input edge to report holding it loaded into the endpoint bank. */
+			uint16_t LoopTime[HISTOGRAM_NUM_BUCKETS]; /**< Main loop iteration, not counting sleep. */
+			uint16_t WorstEdgeToReport; /**< Longest input edge to report holding it loaded into the endpoint bank. */
+			uint32_t AsleepTicks; /**< Time the main loop spent in idle sleep, zero without SLEEP_SCHEDULER. */
+			uint32_t AwakeTicks; /**< Time the main loop spent running, zero without SLEEP_SCHEDULER. */
+		} ATTR_PACKED USB_JoystickStatsReport_Data_t;
 
 		/* Button mapping structures: */
 		typedef enum {
@@ -87,13 +172,73 @@
 			uint8_t mask;
 		} InputMap_t;
 
+		/** Steps of the map input state machine. */
+		typedef enum {
+			MAP_STATE_IDLE = 0, /**< Nothing to do, the LED shows button presses. */
+			MAP_STATE_START, /**< Blinking slowly to announce a remap. */
+			MAP_STATE_SCAN, /**< Cycling through inputs, waiting for one to be held for a second. */
+			MAP_STATE_CONFIRM, /**< Input found, LED off for a second before the next button. */
+			MAP_STATE_BLINK, /**< Blinking to confirm a setting changed at boot. */
+		} MapState_t;
+
+		/** Input edge captured by the pin change interrupts, in INPUT_CAPTURE_MODE. */
+		typedef struct {
+			uint16_t timestamp; /**< Timer1 count when the edge was seen. */
+			uint8_t port; /**< Port of the edge, as MapPort_t. */
+			uint8_t pressed; /**< Inputs of the port pressed right after the edge. */
+		} InputEvent_t;
+
+		/** Pressed state of all input ports, latched at once. Bits are set for pressed inputs. */
+		typedef struct {
+			uint8_t port[MAP_NUM_PORTS];
+		} InputSnapshot_t;
+
 	/* Function Prototypes: */
 		static void SetupHardware(void);
+		static inline void ReportTask(void);
+		static inline void ReportInvalidate(void);
+		static void ReportPublish(void);
+		static void ReportCreate(USB_JoystickReport_Data_t* jsRep);
+		#if defined(SLEEP_SCHEDULER)
+		static void SleepUntilWork(void);
+		#endif
+		#if defined(SLEEP_SCHEDULER) && defined(LATENCY_STATS)
+		static void SleepStatistics(uint32_t* asleep, uint32_t* awake, bool reset);
+		#endif
 		static void InputInit(void);
 
 		static void MapInput(void);
+		static inline void MapInputNext(MapState_t state, uint16_t delayMS);
+		static void MapInputTask(void);
 		static bool IsMapped(uint8_t button, uint8_t orderMap[]);
+		static void SelectSocdPolicy(void);
 		static bool InputPressed(uint8_t button);
+		static void UpdateScanTables(void);
+		static inline void InputScan(InputSnapshot_t* snapshot);
+		static void DebounceInit(void);
+		static void TurboInit(void);
+		static void ConfigReportCreate(USB_JoystickConfigReport_Data_t* config);
+		static bool ConfigReportValid(const USB_JoystickConfigReport_Data_t* config);
+		static void ConfigTask(void);
+		static inline uint16_t TurboOffMask(void);
+		static inline bool InputDebounceTick(void);
+		static inline void InputDebounced(InputSnapshot_t* snapshot);
+		#if defined(USE_TIMESTAMP_TIMER)
+		static void TimestampTimerInit(void);
+		#endif
+		#if defined(INPUT_CAPTURE_MODE)
+		static void InputCaptureInit(void);
+		static inline void InputCapture(MapPort_t port, uint8_t pins);
+		static inline void InputCaptureDrain(InputSnapshot_t* snapshot, uint16_t* timestamp);
+		#endif
+		#if defined(TRACK_EDGE_LATENCY)
+		static inline void LatencyTrackEdges(uint8_t changed, uint8_t pending, uint16_t timestamp);
+		static inline void LatencyReportLoaded(void);
+		static uint16_t LatencyWorstCase(bool reset);
+		static void StatsReportCreate(USB_JoystickStatsReport_Data_t* stats);
+		#endif
+		static inline uint16_t SnapshotButtons(const InputSnapshot_t* snapshot);
+		static inline bool SnapshotPressed(const InputSnapshot_t* snapshot, uint8_t input);
 
 		static inline void LED_on(void);
 		static inline void LED_off(void);
@@ -102,6 +247,7 @@
 		void EVENT_USB_Device_Connect(void);
 		void EVENT_USB_Device_Disconnect(void);
 		void EVENT_USB_Device_ConfigurationChanged(void);
+		void EVENT_USB_Device_Suspend(void);
 		void EVENT_USB_Device_ControlRequest(void);
 		void EVENT_USB_Device_StartOfFrame(void);
 
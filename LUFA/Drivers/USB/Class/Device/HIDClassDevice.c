@@ -50,6 +50,14 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 		case HID_REQ_GetReport:
 			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE))
 			{
+				#if defined(ASYNC_CONTROL_TRANSFERS)
+				if (HIDInterfaceInfo->Config.ControlReportBuffer != NULL)
+				{
+					HID_Device_StartGetReport(HIDInterfaceInfo);
+					break;
+				}
+				#endif
+
 				uint16_t ReportSize = 0;
 				uint8_t  ReportID   = (USB_ControlRequest.wValue & 0xFF);
 				uint8_t  ReportType = (USB_ControlRequest.wValue >> 8) - 1;
@@ -57,9 +65,11 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 
 				memset(ReportData, 0, sizeof(ReportData));
 
+				USB_TRACE_ENTER(USB_TRACE_CREATE_REPORT);
 				CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &ReportID, ReportType, ReportData, &ReportSize);
+				USB_TRACE_LEAVE(USB_TRACE_CREATE_REPORT);
 
-				if (HIDInterfaceInfo->Config.PrevReportINBuffer != NULL)
+				if ((HIDInterfaceInfo->Config.PrevReportINBuffer != NULL) && (ReportType == HID_REPORT_ITEM_In))
 				{
 					memcpy(HIDInterfaceInfo->Config.PrevReportINBuffer, ReportData,
 					       HIDInterfaceInfo->Config.PrevReportINBufferSize);
@@ -80,6 +90,14 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 		case HID_REQ_SetReport:
 			if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE))
 			{
+				#if defined(ASYNC_CONTROL_TRANSFERS)
+				if (HIDInterfaceInfo->Config.ControlReportBuffer != NULL)
+				{
+					HID_Device_StartSetReport(HIDInterfaceInfo);
+					break;
+				}
+				#endif
+
 				uint16_t ReportSize = USB_ControlRequest.wLength;
 				uint8_t  ReportID   = (USB_ControlRequest.wValue & 0xFF);
 				uint8_t  ReportType = (USB_ControlRequest.wValue >> 8) - 1;
@@ -118,19 +136,28 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 		case HID_REQ_SetIdle:
 			if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE))
 			{
+				uint8_t  ReportID  = (USB_ControlRequest.wValue & 0xFF);
+				uint16_t IdleCount = ((USB_ControlRequest.wValue & 0xFF00) >> 6);
+
 				Endpoint_ClearSETUP();
 				Endpoint_ClearStatusStage();
 
-				HIDInterfaceInfo->State.IdleCount = ((USB_ControlRequest.wValue & 0xFF00) >> 6);
+				/* Report ID zero sets the idle period of every input report of the interface */
+				*HID_Device_GetIdleCount(HIDInterfaceInfo, ReportID) = IdleCount;
+
+				for (uint8_t i = 0; !(ReportID) && (i < HIDInterfaceInfo->Config.TotalReportINs); i++)
+				  HIDInterfaceInfo->State.ReportINIdleCount[i] = IdleCount;
 			}
 
 			break;
 		case HID_REQ_GetIdle:
 			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE))
 			{
+				uint16_t IdleCount = *HID_Device_GetIdleCount(HIDInterfaceInfo, (USB_ControlRequest.wValue & 0xFF));
+
 				Endpoint_ClearSETUP();
 				while (!(Endpoint_IsINReady()));
-				Endpoint_Write_8(HIDInterfaceInfo->State.IdleCount >> 2);
+				Endpoint_Write_8(IdleCount >> 2);
 				Endpoint_ClearIN();
 				Endpoint_ClearStatusStage();
 			}
@@ -139,17 +166,100 @@ void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInter
 	}
 }
 
+#if defined(ASYNC_CONTROL_TRANSFERS)
+static void HID_Device_StartGetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	uint8_t* Buffer     = HIDInterfaceInfo->Config.ControlReportBuffer;
+	uint16_t ReportSize = 0;
+	uint8_t  ReportID   = (USB_ControlRequest.wValue & 0xFF);
+	uint8_t  ReportType = (USB_ControlRequest.wValue >> 8) - 1;
+
+	memset(Buffer, 0, HIDInterfaceInfo->Config.PrevReportINBufferSize + 1);
+
+	USB_TRACE_ENTER(USB_TRACE_CREATE_REPORT);
+	CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &ReportID, ReportType, &Buffer[1], &ReportSize);
+	USB_TRACE_LEAVE(USB_TRACE_CREATE_REPORT);
+
+	if ((HIDInterfaceInfo->Config.PrevReportINBuffer != NULL) && (ReportType == HID_REPORT_ITEM_In))
+	{
+		memcpy(HIDInterfaceInfo->Config.PrevReportINBuffer, &Buffer[1],
+		       HIDInterfaceInfo->Config.PrevReportINBufferSize);
+	}
+
+	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+
+	Endpoint_ClearSETUP();
+
+	/* The report ID goes out in the same stream as the report, from the byte before it */
+	if (ReportID)
+	{
+		Buffer[0] = ReportID;
+		Endpoint_Start_Control_Stream_LE(Buffer, ReportSize + 1, MEMSPACE_RAM);
+	}
+	else
+	{
+		Endpoint_Start_Control_Stream_LE(&Buffer[1], ReportSize, MEMSPACE_RAM);
+	}
+}
+
+static void HID_Device_StartSetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	/* Left for the core to stall if the report does not fit */
+	if (USB_ControlRequest.wLength > (HIDInterfaceInfo->Config.PrevReportINBufferSize + 1))
+	  return;
+
+	Endpoint_ClearSETUP();
+	Endpoint_Start_Control_Read_Stream_LE(HIDInterfaceInfo->Config.ControlReportBuffer, USB_ControlRequest.wLength,
+	                                      HID_Device_SetReportComplete, HIDInterfaceInfo);
+}
+
+static void HID_Device_SetReportComplete(void* const Context)
+{
+	USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo = Context;
+
+	uint8_t* Buffer     = HIDInterfaceInfo->Config.ControlReportBuffer;
+	uint16_t ReportSize = USB_ControlRequest.wLength;
+	uint8_t  ReportID   = (USB_ControlRequest.wValue & 0xFF);
+	uint8_t  ReportType = (USB_ControlRequest.wValue >> 8) - 1;
+	uint8_t  IDSize     = ((ReportID && ReportSize) ? 1 : 0);
+
+	CALLBACK_HID_Device_ProcessHIDReport(HIDInterfaceInfo, ReportID, ReportType, &Buffer[IDSize], ReportSize - IDSize);
+}
+#endif
+
+static uint16_t* HID_Device_GetIdleCount(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                         const uint8_t ReportID)
+{
+	for (uint8_t i = 0; ReportID && (i < HIDInterfaceInfo->Config.TotalReportINs); i++)
+	{
+		if (HIDInterfaceInfo->Config.ReportINTable[i].ReportID == ReportID)
+		  return &HIDInterfaceInfo->State.ReportINIdleCount[i];
+	}
+
+	return &HIDInterfaceInfo->State.IdleCount;
+}
+
 bool HID_Device_ConfigureEndpoints(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
 {
+	if (HIDInterfaceInfo->Config.TotalReportINs > HID_DEVICE_MAX_REPORT_INS)
+	  return false;
+
 	memset(&HIDInterfaceInfo->State, 0x00, sizeof(HIDInterfaceInfo->State));
 	HIDInterfaceInfo->State.UsingReportProtocol = true;
 	HIDInterfaceInfo->State.IdleCount           = 500;
 
+	for (uint8_t i = 0; i < HIDInterfaceInfo->Config.TotalReportINs; i++)
+	  HIDInterfaceInfo->State.ReportINIdleCount[i] = 500;
+
 	HIDInterfaceInfo->Config.ReportINEndpoint.Type = EP_TYPE_INTERRUPT;
 
 	if (!(Endpoint_ConfigureEndpointTable(&HIDInterfaceInfo->Config.ReportINEndpoint, 1)))
 	  return false;
 
+	#if defined(INTERRUPT_HID_ENDPOINT)
+	HID_Device_EnableEndpointInterrupt(HIDInterfaceInfo);
+	#endif
+
 	return true;
 }
 
@@ -170,7 +280,18 @@ void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
 
 	Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
 
-	if (Endpoint_IsReadWriteAllowed())
+	if (!(Endpoint_IsReadWriteAllowed()) && !(HID_Device_CanReplaceBank(HIDInterfaceInfo)))
+	  return;
+
+	USB_TRACE_ENTER(USB_TRACE_HID_TASK);
+
+	if ((HIDInterfaceInfo->Config.ReportINBuffers != NULL) || (HIDInterfaceInfo->Config.ReportINTable != NULL))
+	{
+		HID_Device_SendNextReport(HIDInterfaceInfo);
+
+		HIDInterfaceInfo->State.PrevFrameNum = USB_Device_GetFrameNumber();
+	}
+	else
 	{
 		uint8_t  ReportINData[HIDInterfaceInfo->Config.PrevReportINBufferSize];
 		uint8_t  ReportID     = 0;
@@ -178,8 +299,10 @@ void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
 
 		memset(ReportINData, 0, sizeof(ReportINData));
 
+		USB_TRACE_ENTER(USB_TRACE_CREATE_REPORT);
 		bool ForceSend         = CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &ReportID, HID_REPORT_ITEM_In,
 		                                                             ReportINData, &ReportINSize);
+		USB_TRACE_LEAVE(USB_TRACE_CREATE_REPORT);
 		bool StatesChanged     = false;
 		bool IdlePeriodElapsed = (HIDInterfaceInfo->State.IdleCount && !(HIDInterfaceInfo->State.IdleMSRemaining));
 
@@ -189,12 +312,12 @@ void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
 			memcpy(HIDInterfaceInfo->Config.PrevReportINBuffer, ReportINData, HIDInterfaceInfo->Config.PrevReportINBufferSize);
 		}
 
-		if (ReportINSize && (ForceSend || StatesChanged || IdlePeriodElapsed))
+		Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
+
+		if (ReportINSize && (ForceSend || StatesChanged || IdlePeriodElapsed) && HID_Device_ClaimBank(HIDInterfaceInfo))
 		{
 			HIDInterfaceInfo->State.IdleMSRemaining = HIDInterfaceInfo->State.IdleCount;
 
-			Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
-
 			if (ReportID)
 			  Endpoint_Write_8(ReportID);
 
@@ -205,6 +328,220 @@ void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
 
 		HIDInterfaceInfo->State.PrevFrameNum = USB_Device_GetFrameNumber();
 	}
+
+	USB_TRACE_LEAVE(USB_TRACE_HID_TASK);
+}
+
+void HID_Device_PublishReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                              const uint8_t ReportID,
+                              const uint16_t ReportSize,
+                              const bool Changed)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+
+	HIDInterfaceInfo->State.PublishedIndex     ^= 1;
+	HIDInterfaceInfo->State.PublishedReportSize = ReportSize;
+
+	/* The report ID is stored right before the report, so both are sent from the buffer in one stream */
+	*((uint8_t*)HIDInterfaceInfo->Config.ReportINBuffers +
+	  (HIDInterfaceInfo->State.PublishedIndex * HIDInterfaceInfo->Config.ReportINBufferSize)) = ReportID;
+
+	if (Changed)
+	  HIDInterfaceInfo->State.PublishedGeneration++;
+
+	SetGlobalInterruptMask(CurrentGlobalInt);
+
+	#if defined(INTERRUPT_HID_ENDPOINT)
+	if (Changed)
+	  HID_Device_EnableEndpointInterrupt(HIDInterfaceInfo);
+	#endif
+}
+
+static void HID_Device_SendNextReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	uint8_t TotalReports = HIDInterfaceInfo->Config.TotalReportINs;
+	uint8_t ReportIndex  = HIDInterfaceInfo->State.NextReportIN;
+
+	/* The published report, if any, takes its turn after the table entries */
+	if (HIDInterfaceInfo->Config.ReportINBuffers != NULL)
+	  TotalReports++;
+
+	if (ReportIndex >= TotalReports)
+	  ReportIndex = 0;
+
+	/* Send the first report needing it, starting after the last one sent so that every report gets its turn */
+	for (uint8_t ReportsChecked = 0; ReportsChecked < TotalReports; ReportsChecked++)
+	{
+		bool ReportDue;
+
+		if (ReportIndex == HIDInterfaceInfo->Config.TotalReportINs)
+		  ReportDue = HID_Device_SendPublishedReport(HIDInterfaceInfo);
+		else
+		  ReportDue = HID_Device_SendTableReport(HIDInterfaceInfo, ReportIndex);
+
+		if (++ReportIndex == TotalReports)
+		  ReportIndex = 0;
+
+		if (ReportDue)
+		  break;
+	}
+
+	HIDInterfaceInfo->State.NextReportIN = ReportIndex;
+}
+
+static bool HID_Device_SendTableReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                       const uint8_t ReportIndex)
+{
+	const USB_ClassInfo_HID_Device_ReportIN_t* ReportIN = &HIDInterfaceInfo->Config.ReportINTable[ReportIndex];
+
+	uint8_t  ReportINData[HIDInterfaceInfo->Config.PrevReportINBufferSize];
+	uint8_t  ReportID     = ReportIN->ReportID;
+	uint16_t ReportINSize = 0;
+
+	memset(ReportINData, 0, sizeof(ReportINData));
+
+	USB_TRACE_ENTER(USB_TRACE_CREATE_REPORT);
+	bool ForceSend         = CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &ReportID, HID_REPORT_ITEM_In,
+	                                                             ReportINData, &ReportINSize);
+	USB_TRACE_LEAVE(USB_TRACE_CREATE_REPORT);
+	bool StatesChanged     = false;
+	bool IdlePeriodElapsed = (HIDInterfaceInfo->State.ReportINIdleCount[ReportIndex] &&
+	                          !(HIDInterfaceInfo->State.ReportINIdleMSRemaining[ReportIndex]));
+
+	if (ReportIN->PrevReportINBuffer != NULL)
+	{
+		StatesChanged = (memcmp(ReportINData, ReportIN->PrevReportINBuffer, ReportINSize) != 0);
+		memcpy(ReportIN->PrevReportINBuffer, ReportINData, ReportIN->PrevReportINBufferSize);
+	}
+
+	if (!(ReportINSize && (ForceSend || StatesChanged || IdlePeriodElapsed)))
+	  return false;
+
+	Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
+
+	if (HID_Device_ClaimBank(HIDInterfaceInfo))
+	{
+		HIDInterfaceInfo->State.ReportINIdleMSRemaining[ReportIndex] = HIDInterfaceInfo->State.ReportINIdleCount[ReportIndex];
+
+		if (ReportID)
+		  Endpoint_Write_8(ReportID);
+
+		Endpoint_Write_Stream_LE(ReportINData, ReportINSize, NULL);
+
+		Endpoint_ClearIN();
+	}
+
+	return true;
+}
+
+#if defined(INTERRUPT_HID_ENDPOINT)
+void HID_Device_ProcessEndpointInterrupt(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                         const uint8_t EndpointMask)
+{
+	if (!(EndpointMask & (1 << (HIDInterfaceInfo->Config.ReportINEndpoint.Address & ENDPOINT_EPNUM_MASK))))
+	  return;
+
+	HID_Device_USBTask(HIDInterfaceInfo);
+
+	/* Nothing was sent, so the bank stays free - stop interrupting until there is something to send */
+	Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
+
+	if (Endpoint_IsINReady())
+	  USB_INT_Disable(USB_INT_TXINI);
+}
+
+void HID_Device_EnableEndpointInterrupt(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	if (USB_DeviceState != DEVICE_STATE_Configured)
+	  return;
+
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+
+	uint8_t PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
+
+	Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
+
+	/* With every bank queued the interrupt would only fire after the host took the stale report, so replace it now */
+	if (!(Endpoint_IsINReady()) && HID_Device_CanReplaceBank(HIDInterfaceInfo))
+	  HID_Device_USBTask(HIDInterfaceInfo);
+	else
+	  USB_INT_Enable(USB_INT_TXINI);
+
+	Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+#endif
+
+static inline bool HID_Device_CanReplaceBank(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	#if (ARCH == ARCH_AVR8)
+	return (HIDInterfaceInfo->Config.ReportINEndpoint.Banks > 1);
+	#else
+	return false;
+	#endif
+}
+
+static bool HID_Device_ClaimBank(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	if (Endpoint_IsReadWriteAllowed())
+	  return true;
+
+	#if (ARCH == ARCH_AVR8)
+	if (HID_Device_CanReplaceBank(HIDInterfaceInfo))
+	{
+		/* Every bank is queued; the host may already be reading the first one, but the last one is still
+		 * waiting and would go out stale - kill it so that the new report takes its place. The first bank
+		 * keeps its older report, which the host reads before this one */
+		Endpoint_AbortLastIN();
+
+		return Endpoint_IsReadWriteAllowed();
+	}
+	#endif
+
+	return false;
+}
+
+static bool HID_Device_SendPublishedReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+{
+	bool IdlePeriodElapsed = (HIDInterfaceInfo->State.IdleCount && !(HIDInterfaceInfo->State.IdleMSRemaining));
+
+	/* Keep the published report from being swapped while it is loaded into the bank */
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	GlobalInterruptDisable();
+
+	bool ReportDue = (HIDInterfaceInfo->State.PublishedReportSize &&
+	                  ((HIDInterfaceInfo->State.PublishedGeneration != HIDInterfaceInfo->State.SentGeneration) ||
+	                   IdlePeriodElapsed));
+
+	Endpoint_SelectEndpoint(HIDInterfaceInfo->Config.ReportINEndpoint.Address);
+
+	if (ReportDue && HID_Device_ClaimBank(HIDInterfaceInfo))
+	{
+		uint8_t* ReportINData = ((uint8_t*)HIDInterfaceInfo->Config.ReportINBuffers +
+		                         (HIDInterfaceInfo->State.PublishedIndex * HIDInterfaceInfo->Config.ReportINBufferSize));
+		uint16_t ReportINSize = HIDInterfaceInfo->State.PublishedReportSize;
+
+		HIDInterfaceInfo->State.IdleMSRemaining = HIDInterfaceInfo->State.IdleCount;
+
+		/* Send the report ID stored before the report along with it, or skip its byte if there is none */
+		if (*ReportINData)
+		  ReportINSize++;
+		else
+		  ReportINData++;
+
+		Endpoint_Write_Stream_LE(ReportINData, ReportINSize, NULL);
+
+		Endpoint_ClearIN();
+
+		HIDInterfaceInfo->State.SentGeneration = HIDInterfaceInfo->State.PublishedGeneration;
+	}
+
+	SetGlobalInterruptMask(CurrentGlobalInt);
+
+	return ReportDue;
 }
 
 #endif
@@ -68,7 +68,37 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(HID_DEVICE_MAX_REPORT_INS) || defined(__DOXYGEN__)
+				/** Constant indicating the maximum number of entries in the \c ReportINTable of a HID interface, for which
+				 *  the driver keeps an idle rate and an idle countdown in the interface state. By default this is set to 4
+				 *  entries, but this can be overridden by defining \c HID_DEVICE_MAX_REPORT_INS to another non-zero value in
+				 *  the user project makefile, passing the define to the compiler using the -D compiler switch.
+				 */
+				#define HID_DEVICE_MAX_REPORT_INS     4
+			#endif
+
 		/* Type Defines: */
+			/** \brief HID Class Device Mode Input Report Table Entry.
+			 *
+			 *  Describes one input report ID of a HID interface issuing several input reports, so that the driver can
+			 *  detect changes and time the idle period of that report separately from the others. A table of these is
+			 *  given to the driver through the \c ReportINTable member of \ref USB_ClassInfo_HID_Device_t, and may be
+			 *  constant. The idle rate and countdown of each entry are kept in the interface state.
+			 */
+			typedef struct
+			{
+				uint8_t  ReportID; /**< Report ID of the input report, passed to \ref CALLBACK_HID_Device_CreateHIDReport()
+				                    *   to select the report to create.
+				                    */
+				void*    PrevReportINBuffer; /**< Pointer to a buffer where the previous report with this ID is stored, for
+				                              *   comparison purposes, or \c NULL if the application forces transfers itself.
+				                              */
+				uint8_t  PrevReportINBufferSize; /**< Size in bytes of \c PrevReportINBuffer, no larger than the interface's
+				                                  *   \c PrevReportINBufferSize.
+				                                  */
+			} USB_ClassInfo_HID_Device_ReportIN_t;
+
 			/** \brief HID Class Device Mode Configuration and State Structure.
 			 *
 			 *  Class state structure. An instance of this structure should be made for each HID interface
@@ -85,7 +115,12 @@
 				{
 					uint8_t  InterfaceNumber; /**< Interface number of the HID interface within the device. */
 
-					USB_Endpoint_Table_t ReportINEndpoint; /**< Data IN HID report endpoint configuration table. */
+					USB_Endpoint_Table_t ReportINEndpoint; /**< Data IN HID report endpoint configuration table. If the endpoint
+					                                        *   is double banked, a new report replaces the one queued in the last
+					                                        *   bank. The first bank is never replaced, as the host may already be
+					                                        *   reading it, so when both banks are full the host still reads one older
+					                                        *   report before the latest one.
+					                                        */
 
 					void*    PrevReportINBuffer; /**< Pointer to a buffer where the previously created HID input report can be
 					                              *  stored by the driver, for comparison purposes to detect report changes that
@@ -96,8 +131,7 @@
 					                              *
 					                              *  \note Due to the single buffer, the internal driver can only correctly compare
 					                              *        subsequent reports with identical report IDs. In multiple report devices,
-					                              *        this buffer should be set to \c NULL and the decision to send reports made
-					                              *        by the user application instead.
+					                              *        this buffer should be set to \c NULL and \c ReportINTable used instead.
 					                              */
 					uint8_t  PrevReportINBufferSize; /**< Size in bytes of the given input report buffer. This is used to create a
 					                                  *  second buffer of the same size within the driver so that subsequent reports
@@ -105,6 +139,43 @@
 					                                  *  exclusively (i.e. \c PrevReportINBuffer is \c NULL) this value must still be
 					                                  *  set to the size of the largest report the device can issue to the host.
 					                                  */
+					void*    ReportINBuffers; /**< Pointer to a buffer of twice \c ReportINBufferSize bytes, used by the driver as
+					                           *  a double buffer for input reports published by the application through
+					                           *  \ref HID_Device_PublishReport(). If set, \ref HID_Device_USBTask() sends the latest
+					                           *  published report directly, without calling \ref CALLBACK_HID_Device_CreateHIDReport()
+					                           *  or comparing and copying reports, and \c PrevReportINBuffer may be \c NULL. If this
+					                           *  is \c NULL, input reports are created through the callback function.
+					                           *
+					                           *  \note \ref CALLBACK_HID_Device_CreateHIDReport() is still used to answer HID
+					                           *        GetReport requests from the host.
+					                           *
+					                           *  \note The published report may be used along with \c ReportINTable, for reports
+					                           *        built at their own pace, as long as its report ID is not in the table.
+					                           */
+					uint8_t  ReportINBufferSize; /**< Size in bytes of each half of \c ReportINBuffers: a report ID byte, followed
+					                              *   by the largest input report published. Reports are sent from each half as
+					                              *   they are laid out, ID included, so feature reports answered through
+					                              *   \c PrevReportINBufferSize do not need to fit.
+					                              */
+					void*    ControlReportBuffer; /**< Pointer to a buffer of \c PrevReportINBufferSize + 1 bytes, holding a report
+					                               *   ID and a report, for HID GetReport and SetReport requests. If set and the
+					                               *   \c ASYNC_CONTROL_TRANSFERS token is defined, their data stages run from the
+					                               *   control endpoint interrupt through this buffer instead of busy-waiting on a
+					                               *   stack buffer, and \ref CALLBACK_HID_Device_ProcessHIDReport() is called from that
+					                               *   interrupt. SetReport requests longer than the buffer are stalled. Otherwise
+					                               *   this may be \c NULL.
+					                               */
+					const USB_ClassInfo_HID_Device_ReportIN_t* ReportINTable; /**< Pointer to a table of the input reports issued by
+					                                                           *   the interface, for devices with several report IDs.
+					                                                           *   If set, each report is created through the callback
+					                                                           *   function with its own report ID, compared against its
+					                                                           *   own previous report and sent on its own idle period,
+					                                                           *   and \c PrevReportINBuffer may be \c NULL. Reports that
+					                                                           *   must be sent are sent one per frame, round-robin in
+					                                                           *   table order, followed by the published report if
+					                                                           *   \c ReportINBuffers is also set.
+					                                                           */
+					uint8_t  TotalReportINs; /**< Number of entries in \c ReportINTable, at most \ref HID_DEVICE_MAX_REPORT_INS. */
 				} Config; /**< Config data for the USB class interface within the device. All elements in this section
 				           *   <b>must</b> be set or the interface will fail to enumerate and operate correctly.
 				           */
@@ -112,9 +183,21 @@
 				{
 					bool     UsingReportProtocol; /**< Indicates if the HID interface is set to Boot or Report protocol mode. */
 					uint16_t PrevFrameNum; /**< Frame number of the previous HID report packet opportunity. */
-					uint16_t IdleCount; /**< Report idle period, in milliseconds, set by the host. */
+					uint16_t IdleCount; /**< Report idle period, in milliseconds, set by the host, for the reports not in
+					                     *   \c ReportINTable. */
 					uint16_t IdleMSRemaining; /**< Total number of milliseconds remaining before the idle period elapsed - this
 				                               *   should be decremented by the user application if non-zero each millisecond. */
+					uint16_t ReportINIdleCount[HID_DEVICE_MAX_REPORT_INS]; /**< Idle period of each \c ReportINTable entry, in
+					                                                        *   milliseconds, set by the host. */
+					uint16_t ReportINIdleMSRemaining[HID_DEVICE_MAX_REPORT_INS]; /**< Milliseconds remaining before the idle
+					                                                              *   period of each \c ReportINTable entry
+					                                                              *   elapses. */
+					uint8_t  PublishedIndex; /**< Half of \c ReportINBuffers holding the latest published report. */
+					uint16_t PublishedReportSize; /**< Size in bytes of the latest published report, zero if none. */
+					uint8_t  PublishedGeneration; /**< Incremented by \ref HID_Device_PublishReport() when a report changed. */
+					uint8_t  SentGeneration; /**< Value of \c PublishedGeneration when a report was last sent. */
+					uint8_t  NextReportIN; /**< Index of the \c ReportINTable entry checked first on the next report opportunity,
+					                        *   or \c TotalReportINs for the published report. */
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 				          *   are reset to their defaults when the interface is enumerated.
 				          */
@@ -145,6 +228,52 @@
 			 */
 			void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 
+			#if defined(INTERRUPT_HID_ENDPOINT) || defined(__DOXYGEN__)
+			/** Services the report IN endpoint of the given HID class interface from the USB endpoint interrupt, loading the next
+			 *  report as soon as the host has taken the previous one. This should be linked to the library
+			 *  \ref EVENT_USB_Device_EndpointInterrupt() event, and replaces the calls to \ref HID_Device_USBTask() from the main
+			 *  program loop.
+			 *
+			 *  The endpoint interrupt is left disabled while the bank is free and there is nothing to send, and is enabled again
+			 *  by \ref HID_Device_PublishReport() and \ref HID_Device_MillisecondElapsed().
+			 *
+			 *  \pre This function only exists if the \c INTERRUPT_HID_ENDPOINT token is passed to the compiler via the -D switch.
+			 *
+			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
+			 *  \param[in]     EndpointMask      Mask of the endpoints that have interrupted, passed to the event.
+			 */
+			void HID_Device_ProcessEndpointInterrupt(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+			                                         const uint8_t EndpointMask) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Enables the endpoint interrupt of the report IN endpoint of the given HID class interface, so that
+			 *  \ref HID_Device_ProcessEndpointInterrupt() runs as soon as the endpoint bank is free. If the endpoint is
+			 *  double banked and both banks are queued, the queued report is replaced right away instead, as no bank
+			 *  would free up before the host had read it.
+			 *
+			 *  \pre This function only exists if the \c INTERRUPT_HID_ENDPOINT token is passed to the compiler via the -D switch.
+			 *
+			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
+			 */
+			void HID_Device_EnableEndpointInterrupt(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+			#endif
+
+			/** Publishes the input report written to the buffer returned by \ref HID_Device_GetPublishBuffer(), when the
+			 *  interface uses the \c ReportINBuffers double buffer. The report becomes the one sent by \ref HID_Device_USBTask()
+			 *  on the next free endpoint bank, replacing any published report not sent yet. This may be called from an
+			 *  interrupt.
+			 *
+			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
+			 *  \param[in]     ReportID          Report ID of the published report, or zero if report IDs are not used.
+			 *  \param[in]     ReportSize        Size in bytes of the published report, not counting the report ID. At most
+			 *                                   \c ReportINBufferSize - 1.
+			 *  \param[in]     Changed           Whether the report differs from the previous one and must be sent, instead of
+			 *                                   waiting for the idle period.
+			 */
+			void HID_Device_PublishReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+			                              const uint8_t ReportID,
+			                              const uint16_t ReportSize,
+			                              const bool Changed) ATTR_NON_NULL_PTR_ARG(1);
+
 			/** HID class driver callback for the user creation of a HID IN report. This callback may fire in response to either
 			 *  HID class control requests from the host, or by the normal HID endpoint polling procedure. Inside this callback the
 			 *  user is responsible for the creation of the next HID input report to be sent to the host.
@@ -197,8 +326,60 @@
 			{
 				if (HIDInterfaceInfo->State.IdleMSRemaining)
 				  HIDInterfaceInfo->State.IdleMSRemaining--;
+
+				for (uint8_t i = 0; i < HIDInterfaceInfo->Config.TotalReportINs; i++)
+				{
+					if (HIDInterfaceInfo->State.ReportINIdleMSRemaining[i])
+					  HIDInterfaceInfo->State.ReportINIdleMSRemaining[i]--;
+				}
+
+				#if defined(INTERRUPT_HID_ENDPOINT)
+				/* Retry reports held back to the next frame, or due because the idle period elapsed */
+				if ((HIDInterfaceInfo->Config.ReportINBuffers == NULL) || HIDInterfaceInfo->Config.TotalReportINs ||
+				    (HIDInterfaceInfo->State.PublishedGeneration != HIDInterfaceInfo->State.SentGeneration) ||
+				    (HIDInterfaceInfo->State.IdleCount && !(HIDInterfaceInfo->State.IdleMSRemaining)))
+				{
+					HID_Device_EnableEndpointInterrupt(HIDInterfaceInfo);
+				}
+				#endif
 			}
 
+			/** Retrieves the half of the \c ReportINBuffers double buffer not holding the latest published report, where the
+			 *  application should write its next input report before calling \ref HID_Device_PublishReport(). The buffer is
+			 *  \c ReportINBufferSize - 1 bytes long, following the byte where the driver stores the report ID.
+			 *
+			 *  \param[in] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
+			 *
+			 *  \return Pointer to the buffer for the next input report.
+			 */
+			static inline void* HID_Device_GetPublishBuffer(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_ALWAYS_INLINE ATTR_NON_NULL_PTR_ARG(1);
+			static inline void* HID_Device_GetPublishBuffer(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo)
+			{
+				return ((uint8_t*)HIDInterfaceInfo->Config.ReportINBuffers +
+				        ((HIDInterfaceInfo->State.PublishedIndex ^ 1) * HIDInterfaceInfo->Config.ReportINBufferSize) + 1);
+			}
+
+	/* Private Interface - For use in library only: */
+	#if !defined(__DOXYGEN__)
+		/* Function Prototypes: */
+			#if defined(__INCLUDE_FROM_HID_DEVICE_C)
+				static inline bool HID_Device_CanReplaceBank(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_ALWAYS_INLINE ATTR_NON_NULL_PTR_ARG(1);
+				static bool HID_Device_ClaimBank(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static bool HID_Device_SendPublishedReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static bool HID_Device_SendTableReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+				                                       const uint8_t ReportIndex) ATTR_NON_NULL_PTR_ARG(1);
+				static uint16_t* HID_Device_GetIdleCount(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+				                                         const uint8_t ReportID) ATTR_NON_NULL_PTR_ARG(1);
+
+				#if defined(ASYNC_CONTROL_TRANSFERS)
+				static void HID_Device_StartGetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static void HID_Device_StartSetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static void HID_Device_SetReportComplete(void* const Context) ATTR_NON_NULL_PTR_ARG(1);
+				#endif
+				static void HID_Device_SendNextReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+			#endif
+	#endif
+
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			}
@@ -73,6 +73,10 @@
 			#error USE_FLASH_DESCRIPTORS and USE_EEPROM_DESCRIPTORS are mutually exclusive.
 		#endif
 
+		#if (defined(DEFERRED_USB_EVENTS) && !(defined(USB_SERIES_4_AVR) || defined(USB_SERIES_6_AVR) || defined(USB_SERIES_7_AVR)))
+			#error DEFERRED_USB_EVENTS is only supported on USB AVRs with VBUS detection (Series 4, 6 and 7).
+		#endif
+
 		#if (defined(USE_FLASH_DESCRIPTORS) && defined(USE_RAM_DESCRIPTORS))
 			#error USE_FLASH_DESCRIPTORS and USE_RAM_DESCRIPTORS are mutually exclusive.
 		#endif
@@ -190,6 +194,60 @@
 				}
 			#endif
 
+			#if defined(DEFERRED_USB_EVENTS) || defined(__DOXYGEN__)
+				#if !defined(__DOXYGEN__)
+				extern volatile uint8_t USB_Device_DeferredEvents;
+				#endif
+
+				/** Determines if bus events queued by the USB interrupt are still waiting for \ref USB_USBTask() to
+				 *  complete them. While this returns \c true the application must keep calling \ref USB_USBTask(),
+				 *  and must not enter a sleep mode that stops the USB PLL.
+				 *
+				 *  \note This function is only available when the \c DEFERRED_USB_EVENTS compile time token is defined.
+				 *
+				 *  \return Boolean \c true if a connection, disconnection or wake up is not complete yet.
+				 */
+				static inline bool USB_Device_HasDeferredEvents(void) ATTR_ALWAYS_INLINE ATTR_WARN_UNUSED_RESULT;
+				static inline bool USB_Device_HasDeferredEvents(void)
+				{
+					return (USB_Device_DeferredEvents != 0);
+				}
+			#endif
+
+			#if defined(USB_ISR_TIMER) || defined(__DOXYGEN__)
+				#if !defined(__DOXYGEN__)
+				extern volatile uint16_t USB_Device_WorstISRTime;
+				#endif
+
+				/** Retrieves the longest run of the USB general interrupt seen, from the start of its body to its end,
+				 *  in counts of the \c USB_ISR_TIMER counter. The interrupt runs with all other interrupts blocked, so
+				 *  this bounds the latency it adds to them, short of the register saving and restoring around it.
+				 *
+				 *  \note This function is only available when the \c USB_ISR_TIMER compile time token is defined.
+				 *
+				 *  \param[in] Reset  If \c true, the measurement is restarted after it is read.
+				 *
+				 *  \return Longest USB general interrupt since the last reset, in \c USB_ISR_TIMER counts.
+				 */
+				static inline uint16_t USB_Device_GetWorstISRTime(const bool Reset) ATTR_ALWAYS_INLINE;
+				static inline uint16_t USB_Device_GetWorstISRTime(const bool Reset)
+				{
+					uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+					uint16_t   WorstISRTime;
+
+					GlobalInterruptDisable();
+
+					WorstISRTime = USB_Device_WorstISRTime;
+
+					if (Reset)
+					  USB_Device_WorstISRTime = 0;
+
+					SetGlobalInterruptMask(CurrentGlobalInt);
+
+					return WorstISRTime;
+				}
+			#endif
+
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
 		/* Inline Functions: */
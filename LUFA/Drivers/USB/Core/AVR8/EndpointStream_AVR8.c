@@ -38,6 +38,39 @@
 
 #include "EndpointStream_AVR8.h"
 
+#if defined(ASYNC_CONTROL_TRANSFERS)
+	#include "../USBInterrupt.h"
+#endif
+
+#if defined(ARCH_HAS_FLASH_ADDRESS_SPACE)
+/* Copies a block of FLASH into the selected endpoint's bank, using post-incrementing LPM loads so that each byte
+ * costs one load, one store and the loop branch. Length must be between 1 and the space left in the bank, and the
+ * advanced FLASH pointer is returned. */
+static inline const uint8_t* Endpoint_Write_PBlock(const uint8_t* FlashAddress,
+                                                   uint16_t Length) ATTR_ALWAYS_INLINE;
+static inline const uint8_t* Endpoint_Write_PBlock(const uint8_t* FlashAddress,
+                                                   uint16_t Length)
+{
+	#if defined(__AVR_ARCH__)
+	uint8_t Byte;
+
+	__asm__ __volatile__ ("1: lpm  %[Byte], Z+"      "\n\t"
+	                      "   sts  %[Data], %[Byte]" "\n\t"
+	                      "   sbiw %[Length], 1"     "\n\t"
+	                      "   brne 1b"
+	                      : [Byte] "=&r" (Byte), "+z" (FlashAddress), [Length] "+w" (Length)
+	                      : [Data] "n" (_SFR_MEM_ADDR(UEDATX))
+	                      : "memory");
+	#else
+	/* Non-AVR compilers, such as the host build of the simulator in sim/. */
+	while (Length--)
+	  UEDATX = pgm_read_byte(FlashAddress++);
+	#endif
+
+	return FlashAddress;
+}
+#endif
+
 #if !defined(CONTROL_ONLY_DEVICE)
 uint8_t Endpoint_Discard_Stream(uint16_t Length,
                                 uint16_t* const BytesProcessed)
@@ -126,6 +159,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 #define  TEMPLATE_BUFFER_OFFSET(Length)            0
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr += Amount
 #define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(*BufferPtr)
+#define  TEMPLATE_BANK_BYTES()                     (Endpoint_GetBankSize() - Endpoint_BytesInEndpoint())
 #include "Template/Template_Endpoint_RW.c"
 
 #define  TEMPLATE_FUNC_NAME                        Endpoint_Write_Stream_BE
@@ -134,6 +168,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 #define  TEMPLATE_BUFFER_OFFSET(Length)            (Length - 1)
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr -= Amount
 #define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(*BufferPtr)
+#define  TEMPLATE_BANK_BYTES()                     (Endpoint_GetBankSize() - Endpoint_BytesInEndpoint())
 #include "Template/Template_Endpoint_RW.c"
 
 #define  TEMPLATE_FUNC_NAME                        Endpoint_Read_Stream_LE
@@ -142,6 +177,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 #define  TEMPLATE_BUFFER_OFFSET(Length)            0
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr += Amount
 #define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         *BufferPtr = Endpoint_Read_8()
+#define  TEMPLATE_BANK_BYTES()                     Endpoint_BytesInEndpoint()
 #include "Template/Template_Endpoint_RW.c"
 
 #define  TEMPLATE_FUNC_NAME                        Endpoint_Read_Stream_BE
@@ -150,6 +186,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 #define  TEMPLATE_BUFFER_OFFSET(Length)            (Length - 1)
 #define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr -= Amount
 #define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         *BufferPtr = Endpoint_Read_8()
+#define  TEMPLATE_BANK_BYTES()                     Endpoint_BytesInEndpoint()
 #include "Template/Template_Endpoint_RW.c"
 
 #if defined(ARCH_HAS_FLASH_ADDRESS_SPACE)
@@ -159,6 +196,8 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 	#define  TEMPLATE_BUFFER_OFFSET(Length)            0
 	#define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr += Amount
 	#define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(pgm_read_byte(BufferPtr))
+	#define  TEMPLATE_TRANSFER_BLOCK(BufferPtr, Count) BufferPtr = (uint8_t*)Endpoint_Write_PBlock(BufferPtr, Count)
+	#define  TEMPLATE_BANK_BYTES()                     (Endpoint_GetBankSize() - Endpoint_BytesInEndpoint())
 	#include "Template/Template_Endpoint_RW.c"
 
 	#define  TEMPLATE_FUNC_NAME                        Endpoint_Write_PStream_BE
@@ -167,6 +206,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 	#define  TEMPLATE_BUFFER_OFFSET(Length)            (Length - 1)
 	#define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr -= Amount
 	#define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(pgm_read_byte(BufferPtr))
+	#define  TEMPLATE_BANK_BYTES()                     (Endpoint_GetBankSize() - Endpoint_BytesInEndpoint())
 	#include "Template/Template_Endpoint_RW.c"
 #endif
 
@@ -204,6 +244,229 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 	#include "Template/Template_Endpoint_RW.c"
 #endif
 
+uint8_t Endpoint_Write_Stream_Vector(const USB_Endpoint_Segment_t* const Segments,
+                                     const uint8_t TotalSegments,
+                                     uint16_t* const BytesProcessed)
+{
+	uint16_t BytesToSkip     = ((BytesProcessed != NULL) ? *BytesProcessed : 0);
+	uint16_t BytesInSegments = 0;
+	uint8_t  ErrorCode;
+
+	for (uint8_t SegmentIndex = 0; SegmentIndex < TotalSegments; SegmentIndex++)
+	{
+		const USB_Endpoint_Segment_t* Segment = &Segments[SegmentIndex];
+		uint16_t SegmentProcessed;
+
+		/* Segments already written by a previous partial call are skipped entirely. */
+		if (BytesToSkip >= Segment->Length)
+		{
+			BytesToSkip     -= Segment->Length;
+			BytesInSegments += Segment->Length;
+			continue;
+		}
+
+		SegmentProcessed = BytesToSkip;
+		BytesToSkip      = 0;
+
+		uint16_t* const SegmentBytesProcessed = ((BytesProcessed != NULL) ? &SegmentProcessed : NULL);
+
+		switch (Segment->MemorySpace)
+		{
+			#if defined(ARCH_HAS_FLASH_ADDRESS_SPACE)
+			case MEMSPACE_FLASH:
+				ErrorCode = Endpoint_Write_PStream_LE(Segment->Buffer, Segment->Length, SegmentBytesProcessed);
+				break;
+			#endif
+			#if defined(ARCH_HAS_EEPROM_ADDRESS_SPACE)
+			case MEMSPACE_EEPROM:
+				ErrorCode = Endpoint_Write_EStream_LE(Segment->Buffer, Segment->Length, SegmentBytesProcessed);
+				break;
+			#endif
+			default:
+				ErrorCode = Endpoint_Write_Stream_LE(Segment->Buffer, Segment->Length, SegmentBytesProcessed);
+				break;
+		}
+
+		if (ErrorCode == ENDPOINT_RWSTREAM_IncompleteTransfer)
+		  *BytesProcessed = (BytesInSegments + SegmentProcessed);
+
+		if (ErrorCode)
+		  return ErrorCode;
+
+		BytesInSegments += Segment->Length;
+	}
+
+	/* A full last bank is indistinguishable from more data to come, so it is followed by a zero length packet. */
+	bool LastBankFull = !(Endpoint_IsReadWriteAllowed());
+
+	Endpoint_ClearIN();
+
+	if (LastBankFull)
+	{
+		if ((ErrorCode = Endpoint_WaitUntilReady()))
+		  return ErrorCode;
+
+		Endpoint_ClearIN();
+	}
+
+	return ENDPOINT_RWSTREAM_NoError;
+}
+
+#endif
+
+#if defined(ASYNC_CONTROL_TRANSFERS)
+/** Stages of a non-blocking control transfer. */
+enum Endpoint_ControlStreamStages_t
+{
+	CONTROL_STREAM_Idle,      /**< No transfer in progress. */
+	CONTROL_STREAM_DataIN,    /**< Sending data stage packets as the host reads them. */
+	CONTROL_STREAM_StatusOUT, /**< All data sent, waiting for the host's status stage packet. */
+	CONTROL_STREAM_DataOUT,   /**< Receiving data stage packets as the host sends them. */
+	CONTROL_STREAM_StatusIN,  /**< All data received, sending the status stage packet. */
+};
+
+/** State of the non-blocking control transfer in progress. */
+static struct
+{
+	union
+	{
+		const uint8_t* Source;     /**< Next byte to send, in a device to host transfer. */
+		uint8_t*       Destination; /**< Next byte to fill, in a host to device transfer. */
+	} Buffer;
+	uint16_t       Length;         /**< Bytes left to send or receive. */
+	uint8_t        MemorySpace;    /**< Memory space of the source buffer, a MEMSPACE_* value. */
+	bool           LastPacketFull; /**< Set while a (zero length) packet must follow the last one sent. */
+	bool           ShortOfRequest; /**< Set if less data is sent than the host requested, so it ends with a short packet. */
+	uint8_t        Stage;          /**< Endpoint_ControlStreamStages_t of the transfer. */
+	Endpoint_ControlStreamCallback_t Callback; /**< Called once a host to device transfer completed, or \c NULL. */
+	void*          Context;        /**< Passed to \c Callback. */
+} ControlStream;
+
+void Endpoint_Start_Control_Stream_LE(const void* const Buffer,
+                                      uint16_t Length,
+                                      const uint8_t MemorySpace)
+{
+	if (Length > USB_ControlRequest.wLength)
+	  Length = USB_ControlRequest.wLength;
+
+	ControlStream.Buffer.Source  = Buffer;
+	ControlStream.Length         = Length;
+	ControlStream.MemorySpace    = MemorySpace;
+	ControlStream.LastPacketFull = !(Length); /* An empty data stage is a single zero length packet. */
+	ControlStream.ShortOfRequest = (Length < USB_ControlRequest.wLength);
+	ControlStream.Stage          = CONTROL_STREAM_DataIN;
+}
+
+void Endpoint_Start_Control_Read_Stream_LE(void* const Buffer,
+                                           const uint16_t Length,
+                                           const Endpoint_ControlStreamCallback_t Callback,
+                                           void* const Context)
+{
+	ControlStream.Buffer.Destination = Buffer;
+	ControlStream.Length             = Length;
+	ControlStream.Callback           = Callback;
+	ControlStream.Context            = Context;
+	ControlStream.Stage              = (Length ? CONTROL_STREAM_DataOUT : CONTROL_STREAM_StatusIN);
+}
+
+bool Endpoint_IsControlStreamActive(void)
+{
+	return (ControlStream.Stage != CONTROL_STREAM_Idle);
+}
+
+void Endpoint_Continue_Control_Stream(void)
+{
+	if (ControlStream.Stage == CONTROL_STREAM_DataIN)
+	{
+		if (Endpoint_IsOUTReceived())
+		{
+			/* The host ended the data stage early, and this is its status stage. */
+			Endpoint_ClearOUT();
+			ControlStream.Stage = CONTROL_STREAM_Idle;
+		}
+		else if (Endpoint_IsINReady())
+		{
+			uint8_t BytesInPacket = MIN(ControlStream.Length, USB_Device_ControlEndpointSize);
+
+			ControlStream.Length        -= BytesInPacket;
+
+			/* A data stage filling the request exactly ends with its last full packet, the host stops reading there */
+			ControlStream.LastPacketFull = ControlStream.ShortOfRequest && (BytesInPacket == USB_Device_ControlEndpointSize);
+
+			switch (ControlStream.MemorySpace)
+			{
+				#if defined(ARCH_HAS_FLASH_ADDRESS_SPACE)
+				case MEMSPACE_FLASH:
+					if (BytesInPacket)
+					  ControlStream.Buffer.Source = Endpoint_Write_PBlock(ControlStream.Buffer.Source, BytesInPacket);
+					break;
+				#endif
+				#if defined(ARCH_HAS_EEPROM_ADDRESS_SPACE)
+				case MEMSPACE_EEPROM:
+					while (BytesInPacket--)
+					  Endpoint_Write_8(eeprom_read_byte(ControlStream.Buffer.Source++));
+					break;
+				#endif
+				default:
+					while (BytesInPacket--)
+					  Endpoint_Write_8(*(ControlStream.Buffer.Source++));
+					break;
+			}
+
+			Endpoint_ClearIN();
+
+			if (!(ControlStream.Length) && !(ControlStream.LastPacketFull))
+			  ControlStream.Stage = CONTROL_STREAM_StatusOUT;
+		}
+	}
+	else if ((ControlStream.Stage == CONTROL_STREAM_StatusOUT) && Endpoint_IsOUTReceived())
+	{
+		Endpoint_ClearOUT();
+		ControlStream.Stage = CONTROL_STREAM_Idle;
+	}
+	else if ((ControlStream.Stage == CONTROL_STREAM_DataOUT) && Endpoint_IsOUTReceived())
+	{
+		while (ControlStream.Length && Endpoint_BytesInEndpoint())
+		{
+			*(ControlStream.Buffer.Destination++) = Endpoint_Read_8();
+			ControlStream.Length--;
+		}
+
+		Endpoint_ClearOUT();
+
+		if (!(ControlStream.Length))
+		  ControlStream.Stage = CONTROL_STREAM_StatusIN;
+	}
+
+	if ((ControlStream.Stage == CONTROL_STREAM_StatusIN) && Endpoint_IsINReady())
+	{
+		Endpoint_ClearIN();
+		ControlStream.Stage = CONTROL_STREAM_Idle;
+
+		if (ControlStream.Callback != NULL)
+		  ControlStream.Callback(ControlStream.Context);
+	}
+
+	/* Only wake up for the events the current stage waits for. */
+	if ((ControlStream.Stage == CONTROL_STREAM_DataIN) || (ControlStream.Stage == CONTROL_STREAM_StatusIN))
+	  USB_INT_Enable(USB_INT_TXINI);
+	else
+	  USB_INT_Disable(USB_INT_TXINI);
+
+	if ((ControlStream.Stage != CONTROL_STREAM_Idle) && (ControlStream.Stage != CONTROL_STREAM_StatusIN))
+	  USB_INT_Enable(USB_INT_RXOUTI);
+	else
+	  USB_INT_Disable(USB_INT_RXOUTI);
+}
+
+void Endpoint_Abort_Control_Stream(void)
+{
+	ControlStream.Stage    = CONTROL_STREAM_Idle;
+	ControlStream.Callback = NULL;
+
+	USB_INT_Disable(USB_INT_TXINI);
+	USB_INT_Disable(USB_INT_RXOUTI);
+}
 #endif
 
 #define  TEMPLATE_FUNC_NAME                        Endpoint_Write_Control_Stream_LE
@@ -235,6 +498,7 @@ uint8_t Endpoint_Null_Stream(uint16_t Length,
 	#define  TEMPLATE_BUFFER_OFFSET(Length)            0
 	#define  TEMPLATE_BUFFER_MOVE(BufferPtr, Amount)   BufferPtr += Amount
 	#define  TEMPLATE_TRANSFER_BYTE(BufferPtr)         Endpoint_Write_8(pgm_read_byte(BufferPtr))
+	#define  TEMPLATE_TRANSFER_BLOCK(BufferPtr, Count) BufferPtr = (uint8_t*)Endpoint_Write_PBlock(BufferPtr, Count)
 	#include "Template/Template_Endpoint_Control_W.c"
 
 	#define  TEMPLATE_FUNC_NAME                        Endpoint_Write_Control_PStream_BE
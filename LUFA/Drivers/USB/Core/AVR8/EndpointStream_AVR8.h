@@ -64,7 +64,27 @@
 			#error Do not include this file directly. Include LUFA/Drivers/USB/USB.h instead.
 		#endif
 
+		#if defined(ASYNC_CONTROL_TRANSFERS) && !defined(INTERRUPT_CONTROL_ENDPOINT)
+			#error ASYNC_CONTROL_TRANSFERS requires INTERRUPT_CONTROL_ENDPOINT, as transfers advance from the control endpoint interrupt.
+		#endif
+
 	/* Public Interface - May be used in end-application: */
+		/* Type Defines: */
+			/** Type define for one segment of a scattered source buffer, see \ref Endpoint_Write_Stream_Vector(). */
+			typedef struct
+			{
+				const void* Buffer; /**< Pointer to the segment data, in the memory space given by \c MemorySpace. */
+				uint16_t    Length; /**< Length of the segment in bytes. */
+				uint8_t     MemorySpace; /**< Memory space of the segment, a \c MEMSPACE_* value. */
+			} USB_Endpoint_Segment_t;
+
+			/** Type define for the function called once a host to device control transfer started with
+			 *  \ref Endpoint_Start_Control_Read_Stream_LE() has completed.
+			 *
+			 *  \param[in] Context  Pointer given when the transfer was started.
+			 */
+			typedef void (*Endpoint_ControlStreamCallback_t)(void* const Context);
+
 		/* Function Prototypes: */
 			/** \name Stream functions for null data */
 			//@{
@@ -647,6 +667,100 @@
 			                                          uint16_t Length) ATTR_NON_NULL_PTR_ARG(1);
 			//@}
 
+			/** \name Stream functions for scattered source data */
+			//@{
+
+			/** Writes a buffer scattered over several segments to the endpoint, back to back and in little endian,
+			 *  sending full packets to the host as needed. Each segment may be located in RAM, FLASH or EEPROM, and is
+			 *  streamed straight into the endpoint banks, so headers and payloads need not be copied together first.
+			 *
+			 *  Unlike the other stream write functions, the last packet is sent once all segments have been written.
+			 *  If the data ended on a bank boundary, a zero length packet follows to terminate the transfer.
+			 *
+			 *  \note The class drivers do not use this routine, so that their transfers are framed the same way on
+			 *        every architecture; a protocol which does not expect the zero length packet should write its
+			 *        segments with the other stream functions instead.
+			 *
+			 *  If the BytesProcessed parameter is \c NULL, the entire stream transfer is attempted at once. Otherwise
+			 *  the transfer is performed as a series of chunks, as for \ref Endpoint_Write_Stream_LE(), with
+			 *  BytesProcessed counting the bytes written across all segments.
+			 *
+			 *  \note This routine should not be used on CONTROL type endpoints.
+			 *
+			 *  \param[in] Segments        Pointer to the array of segments to write, in order.
+			 *  \param[in] TotalSegments   Number of segments in the array.
+			 *  \param[in] BytesProcessed  Pointer to a location where the total number of bytes processed in the current
+			 *                             transaction should be updated, \c NULL if the entire stream should be written at once.
+			 *
+			 *  \return A value from the \ref Endpoint_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Endpoint_Write_Stream_Vector(const USB_Endpoint_Segment_t* const Segments,
+			                                     const uint8_t TotalSegments,
+			                                     uint16_t* const BytesProcessed) ATTR_NON_NULL_PTR_ARG(1);
+			//@}
+
+			#if defined(ASYNC_CONTROL_TRANSFERS) || defined(__DOXYGEN__)
+			/** \name Non-blocking stream functions for control endpoints */
+			//@{
+
+			/** Starts the data stage of a device to host control transfer, and returns at once. The data is sent one
+			 *  packet at a time from the control endpoint interrupt, as the host reads it, and the status stage is
+			 *  cleared there too, so the caller must neither wait for nor clear it. A new SETUP packet or a bus reset
+			 *  abandons the transfer.
+			 *
+			 *  \pre The buffer must remain valid until the transfer completes, so it must not be on the stack. The
+			 *       SETUP packet must already have been cleared with \ref Endpoint_ClearSETUP().
+			 *
+			 *  \note This function is available only when the \c ASYNC_CONTROL_TRANSFERS token is defined, which
+			 *        requires \c INTERRUPT_CONTROL_ENDPOINT.
+			 *
+			 *  \param[in] Buffer       Pointer to the source data buffer to read from.
+			 *  \param[in] Length       Number of bytes to send, trimmed to the length requested by the host.
+			 *  \param[in] MemorySpace  Memory space of the buffer, a \c MEMSPACE_* value.
+			 */
+			void Endpoint_Start_Control_Stream_LE(const void* const Buffer,
+			                                      uint16_t Length,
+			                                      const uint8_t MemorySpace) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Starts the data stage of a host to device control transfer, and returns at once. The data is read one
+			 *  packet at a time from the control endpoint interrupt, as the host sends it, then the status stage is sent
+			 *  and \c Callback is called, from the same interrupt. A new SETUP packet or a bus reset abandons the
+			 *  transfer, without calling \c Callback.
+			 *
+			 *  \pre The buffer must remain valid until the transfer completes, so it must not be on the stack. The
+			 *       SETUP packet must already have been cleared with \ref Endpoint_ClearSETUP().
+			 *
+			 *  \note This function is available only when the \c ASYNC_CONTROL_TRANSFERS token is defined, which
+			 *        requires \c INTERRUPT_CONTROL_ENDPOINT.
+			 *
+			 *  \param[out] Buffer    Pointer to the destination data buffer, of at least \c Length bytes.
+			 *  \param[in]  Length    Number of bytes to receive, normally the length of the request.
+			 *  \param[in]  Callback  Function called once the transfer completed, or \c NULL.
+			 *  \param[in]  Context   Pointer passed to \c Callback.
+			 */
+			void Endpoint_Start_Control_Read_Stream_LE(void* const Buffer,
+			                                           const uint16_t Length,
+			                                           const Endpoint_ControlStreamCallback_t Callback,
+			                                           void* const Context) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Determines if a control transfer started with \ref Endpoint_Start_Control_Stream_LE() or
+			 *  \ref Endpoint_Start_Control_Read_Stream_LE() is still in its data or status stage.
+			 *
+			 *  \return Boolean \c true if the transfer has not completed yet, \c false otherwise.
+			 */
+			bool Endpoint_IsControlStreamActive(void) ATTR_WARN_UNUSED_RESULT;
+			//@}
+			#endif
+
+	/* Private Interface - For use in library only: */
+	#if !defined(__DOXYGEN__)
+		/* Function Prototypes: */
+			#if defined(ASYNC_CONTROL_TRANSFERS)
+			void Endpoint_Continue_Control_Stream(void);
+			void Endpoint_Abort_Control_Stream(void);
+			#endif
+	#endif
+
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			}
@@ -230,6 +230,18 @@
 				#endif
 			}
 
+			/** Retrieves the size in bytes of each bank of the currently selected endpoint, as configured.
+			 *
+			 *  \ingroup Group_EndpointRW_AVR8
+			 *
+			 *  \return Size of a bank of the currently selected Endpoint's FIFO buffer.
+			 */
+			static inline uint16_t Endpoint_GetBankSize(void) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+			static inline uint16_t Endpoint_GetBankSize(void)
+			{
+				return (8 << ((UECFG1X >> EPSIZE0) & 0x07));
+			}
+
 			/** Determines the currently selected endpoint's direction.
 			 *
 			 *  \return The currently selected endpoint's direction, as a \c ENDPOINT_DIR_* mask.
@@ -343,6 +355,22 @@
 				}
 			}
 
+			/** Aborts the last IN transaction queued on the currently selected endpoint via \ref Endpoint_ClearIN(),
+			 *  freeing its bank for a new packet. On a double banked endpoint, the other bank is left queued, so a
+			 *  packet the host may already be reading is not disturbed.
+			 *
+			 *  \ingroup Group_EndpointPacketManagement_AVR8
+			 */
+			static inline void Endpoint_AbortLastIN(void) ATTR_ALWAYS_INLINE;
+			static inline void Endpoint_AbortLastIN(void)
+			{
+				if (Endpoint_GetBusyBanks() != 0)
+				{
+					UEINTX |= (1 << RXOUTI);
+					while (UEINTX & (1 << RXOUTI));
+				}
+			}
+
 			/** Determines if the currently selected endpoint may be read from (if data is waiting in the endpoint
 			 *  bank and the endpoint is an OUT direction, or if the bank is not yet full if the endpoint is an IN
 			 *  direction). This function will return false if an error has occurred in the endpoint, if the endpoint
@@ -57,14 +57,25 @@ uint8_t TEMPLATE_FUNC_NAME (const void* const Buffer,
 		if (Endpoint_IsINReady())
 		{
 			uint16_t BytesInEndpoint = Endpoint_BytesInEndpoint();
+			uint8_t  BytesInPacket   = 0;
 
-			while (Length && (BytesInEndpoint < USB_Device_ControlEndpointSize))
+			if (BytesInEndpoint < USB_Device_ControlEndpointSize)
+			  BytesInPacket = MIN(Length, USB_Device_ControlEndpointSize - BytesInEndpoint);
+
+			Length          -= BytesInPacket;
+			BytesInEndpoint += BytesInPacket;
+
+			/* Templates may provide a faster copy of a whole block, of one byte up to the space in the bank. */
+			#if defined(TEMPLATE_TRANSFER_BLOCK)
+			if (BytesInPacket)
+			  TEMPLATE_TRANSFER_BLOCK(DataStream, BytesInPacket);
+			#else
+			while (BytesInPacket--)
 			{
 				TEMPLATE_TRANSFER_BYTE(DataStream);
 				TEMPLATE_BUFFER_MOVE(DataStream, 1);
-				Length--;
-				BytesInEndpoint++;
 			}
+			#endif
 
 			LastPacketFull = (BytesInEndpoint == USB_Device_ControlEndpointSize);
 			Endpoint_ClearIN();
@@ -90,6 +101,7 @@ uint8_t TEMPLATE_FUNC_NAME (const void* const Buffer,
 #undef TEMPLATE_BUFFER_MOVE
 #undef TEMPLATE_FUNC_NAME
 #undef TEMPLATE_TRANSFER_BYTE
+#undef TEMPLATE_TRANSFER_BLOCK
 
 #endif
 
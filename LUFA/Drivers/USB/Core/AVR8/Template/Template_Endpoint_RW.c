@@ -30,6 +30,12 @@
 
 #if defined(TEMPLATE_FUNC_NAME)
 
+/* Number of bytes that can be moved before the bank is full or empty. Templates that leave it undefined move
+ * one byte at a time, checking the bank between each. */
+#if !defined(TEMPLATE_BANK_BYTES)
+	#define TEMPLATE_BANK_BYTES()                 1
+#endif
+
 uint8_t TEMPLATE_FUNC_NAME (TEMPLATE_BUFFER_TYPE const Buffer,
                             uint16_t Length,
                             uint16_t* const BytesProcessed)
@@ -68,10 +74,41 @@ uint8_t TEMPLATE_FUNC_NAME (TEMPLATE_BUFFER_TYPE const Buffer,
 		}
 		else
 		{
-			TEMPLATE_TRANSFER_BYTE(DataStream);
-			TEMPLATE_BUFFER_MOVE(DataStream, 1);
-			Length--;
-			BytesInTransfer++;
+			uint16_t BytesInBank = TEMPLATE_BANK_BYTES();
+
+			/* Fall back to a single byte if the bank count is not usable, checking the bank again after it. */
+			if (!(BytesInBank))
+			  BytesInBank = 1;
+
+			if (BytesInBank > Length)
+			  BytesInBank = Length;
+
+			Length          -= BytesInBank;
+			BytesInTransfer += BytesInBank;
+
+			/* Templates may provide a faster copy of a whole block, of one byte up to the space in the bank. */
+			#if defined(TEMPLATE_TRANSFER_BLOCK)
+			TEMPLATE_TRANSFER_BLOCK(DataStream, BytesInBank);
+			#else
+			while (BytesInBank >= 8)
+			{
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				TEMPLATE_TRANSFER_BYTE(DataStream); TEMPLATE_BUFFER_MOVE(DataStream, 1);
+				BytesInBank -= 8;
+			}
+
+			while (BytesInBank--)
+			{
+				TEMPLATE_TRANSFER_BYTE(DataStream);
+				TEMPLATE_BUFFER_MOVE(DataStream, 1);
+			}
+			#endif
 		}
 	}
 
@@ -84,6 +121,8 @@ uint8_t TEMPLATE_FUNC_NAME (TEMPLATE_BUFFER_TYPE const Buffer,
 #undef TEMPLATE_CLEAR_ENDPOINT
 #undef TEMPLATE_BUFFER_OFFSET
 #undef TEMPLATE_BUFFER_MOVE
+#undef TEMPLATE_BANK_BYTES
+#undef TEMPLATE_TRANSFER_BLOCK
 
 #endif
 
@@ -74,18 +74,71 @@ void USB_INT_ClearAllInterrupts(void)
 	#endif
 }
 
-ISR(USB_GEN_vect, ISR_BLOCK)
+#if defined(DEFERRED_USB_EVENTS) && defined(USB_CAN_BE_DEVICE)
+/** Device bus events whose slow part is left by the interrupt to \ref USB_INT_ProcessDeferredEvents(). */
+enum USB_DeferredEvents_t
 {
-	#if defined(USB_CAN_BE_DEVICE)
-	#if !defined(NO_SOF_EVENTS)
-	if (USB_INT_HasOccurred(USB_INT_SOFI) && USB_INT_IsEnabled(USB_INT_SOFI))
+	USB_DEFERRED_Connect    = (1 << 0), /**< VBUS applied, waiting for the PLL to lock. */
+	USB_DEFERRED_Disconnect = (1 << 1), /**< VBUS removed. */
+	USB_DEFERRED_WakeUp     = (1 << 2), /**< Bus activity after a suspension, waiting for the PLL to lock. */
+};
+
+volatile uint8_t USB_Device_DeferredEvents;
+
+void USB_INT_ProcessDeferredEvents(void)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint8_t    CompletedEvents;
+
+	if (!(USB_Device_DeferredEvents))
+	  return;
+
+	GlobalInterruptDisable();
+
+	CompletedEvents = USB_Device_DeferredEvents;
+
+	/* Connections and wake ups are retried on the next call until the PLL has locked. */
+	if (!(USB_Options & USB_OPT_MANUAL_PLL) && !(USB_PLL_IsReady()))
+	  CompletedEvents &= ~(USB_DEFERRED_Connect | USB_DEFERRED_WakeUp);
+
+	USB_Device_DeferredEvents &= ~CompletedEvents;
+
+	if (CompletedEvents & USB_DEFERRED_Connect)
+	  USB_DeviceState = DEVICE_STATE_Powered;
+
+	if (CompletedEvents & USB_DEFERRED_WakeUp)
 	{
-		USB_INT_Clear(USB_INT_SOFI);
+		USB_CLK_Unfreeze();
 
-		EVENT_USB_Device_StartOfFrame();
+		USB_INT_Clear(USB_INT_WAKEUPI);
+		USB_INT_Enable(USB_INT_SUSPI);
+
+		if (USB_Device_ConfigurationNumber)
+		  USB_DeviceState = DEVICE_STATE_Configured;
+		else
+		  USB_DeviceState = (USB_Device_IsAddressSet()) ? DEVICE_STATE_Addressed : DEVICE_STATE_Powered;
 	}
-	#endif
 
+	SetGlobalInterruptMask(CurrentGlobalInt);
+
+	/* The events run with interrupts enabled, in the order their causes occurred on the bus. */
+	if (CompletedEvents & USB_DEFERRED_Disconnect)
+	  EVENT_USB_Device_Disconnect();
+
+	if (CompletedEvents & USB_DEFERRED_Connect)
+	  EVENT_USB_Device_Connect();
+
+	if (CompletedEvents & USB_DEFERRED_WakeUp)
+	  EVENT_USB_Device_WakeUp();
+}
+#endif
+
+/* Handles every general interrupt source except the device start of frame. It is kept out of line, so that the
+ * registers it needs are only saved when one of these rare sources is pending, not on every frame. */
+static void USB_INT_ProcessSlowEvents(void) ATTR_NO_INLINE;
+static void USB_INT_ProcessSlowEvents(void)
+{
+	#if defined(USB_CAN_BE_DEVICE)
 	#if defined(USB_SERIES_4_AVR) || defined(USB_SERIES_6_AVR) || defined(USB_SERIES_7_AVR)
 	if (USB_INT_HasOccurred(USB_INT_VBUSTI) && USB_INT_IsEnabled(USB_INT_VBUSTI))
 	{
@@ -96,11 +149,17 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 			if (!(USB_Options & USB_OPT_MANUAL_PLL))
 			{
 				USB_PLL_On();
+				#if !defined(DEFERRED_USB_EVENTS)
 				while (!(USB_PLL_IsReady()));
+				#endif
 			}
 
+			#if defined(DEFERRED_USB_EVENTS)
+			USB_Device_DeferredEvents |= USB_DEFERRED_Connect;
+			#else
 			USB_DeviceState = DEVICE_STATE_Powered;
 			EVENT_USB_Device_Connect();
+			#endif
 		}
 		else
 		{
@@ -108,7 +167,16 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 			  USB_PLL_Off();
 
 			USB_DeviceState = DEVICE_STATE_Unattached;
+
+			#if defined(DEFERRED_USB_EVENTS)
+			/* A connection not reported yet is dropped silently, along with anything queued after it. */
+			if (USB_Device_DeferredEvents & USB_DEFERRED_Connect)
+			  USB_Device_DeferredEvents &= USB_DEFERRED_Disconnect;
+			else
+			  USB_Device_DeferredEvents  = USB_DEFERRED_Disconnect;
+			#else
 			EVENT_USB_Device_Disconnect();
+			#endif
 		}
 	}
 	#endif
@@ -134,6 +202,13 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 
 	if (USB_INT_HasOccurred(USB_INT_WAKEUPI) && USB_INT_IsEnabled(USB_INT_WAKEUPI))
 	{
+		#if defined(DEFERRED_USB_EVENTS)
+		if (!(USB_Options & USB_OPT_MANUAL_PLL))
+		  USB_PLL_On();
+
+		USB_INT_Disable(USB_INT_WAKEUPI);
+		USB_Device_DeferredEvents |= USB_DEFERRED_WakeUp;
+		#else
 		if (!(USB_Options & USB_OPT_MANUAL_PLL))
 		{
 			USB_PLL_On();
@@ -157,6 +232,7 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 		#else
 		EVENT_USB_Device_WakeUp();
 		#endif
+		#endif
 	}
 
 	if (USB_INT_HasOccurred(USB_INT_EORSTI) && USB_INT_IsEnabled(USB_INT_EORSTI))
@@ -170,6 +246,8 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 		USB_INT_Disable(USB_INT_SUSPI);
 		USB_INT_Enable(USB_INT_WAKEUPI);
 
+		/* Even with DEFERRED_USB_EVENTS, the control endpoint must be ready for the SETUP packet the host sends
+		 * right after the reset, and nothing here waits for the PLL. */
 		Endpoint_ConfigureEndpoint(ENDPOINT_CONTROLEP, EP_TYPE_CONTROL,
 		                           USB_Device_ControlEndpointSize, 1);
 
@@ -177,6 +255,10 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 		USB_INT_Enable(USB_INT_RXSTPI);
 		#endif
 
+		#if defined(ASYNC_CONTROL_TRANSFERS)
+		Endpoint_Abort_Control_Stream();
+		#endif
+
 		EVENT_USB_Device_Reset();
 	}
 	#endif
@@ -257,21 +339,110 @@ ISR(USB_GEN_vect, ISR_BLOCK)
 	#endif
 }
 
-#if defined(INTERRUPT_CONTROL_ENDPOINT) && defined(USB_CAN_BE_DEVICE)
+/* Determines if a general interrupt source other than the device start of frame is pending and enabled. */
+static inline bool USB_INT_HasSlowEventOccurred(void) ATTR_ALWAYS_INLINE;
+static inline bool USB_INT_HasSlowEventOccurred(void)
+{
+	#if defined(USB_CAN_BE_HOST)
+	return true;
+	#else
+	#if defined(USB_SERIES_4_AVR) || defined(USB_SERIES_6_AVR) || defined(USB_SERIES_7_AVR)
+	if (USB_INT_HasOccurred(USB_INT_VBUSTI) && USB_INT_IsEnabled(USB_INT_VBUSTI))
+	  return true;
+	#endif
+
+	/* The device interrupt flags and their enable bits share the same positions. */
+	return (UDINT & UDIEN & ~(1 << SOFI));
+	#endif
+}
+
+#if defined(USB_ISR_TIMER)
+volatile uint16_t USB_Device_WorstISRTime;
+#endif
+
+ISR(USB_GEN_vect, ISR_BLOCK)
+{
+	#if defined(USB_ISR_TIMER)
+	uint16_t ISRStartTime = USB_ISR_TIMER;
+	#endif
+
+	USB_TRACE_ENTER(USB_TRACE_GENERAL_ISR);
+
+	#if defined(USB_CAN_BE_DEVICE) && !defined(NO_SOF_EVENTS)
+	if (USB_INT_HasOccurred(USB_INT_SOFI) && USB_INT_IsEnabled(USB_INT_SOFI))
+	{
+		USB_INT_Clear(USB_INT_SOFI);
+
+		EVENT_USB_Device_StartOfFrame();
+	}
+	#endif
+
+	if (USB_INT_HasSlowEventOccurred())
+	  USB_INT_ProcessSlowEvents();
+
+	USB_TRACE_LEAVE(USB_TRACE_GENERAL_ISR);
+
+	#if defined(USB_ISR_TIMER)
+	uint16_t ISRTime = (uint16_t)(USB_ISR_TIMER - ISRStartTime);
+
+	if (ISRTime > USB_Device_WorstISRTime)
+	  USB_Device_WorstISRTime = ISRTime;
+	#endif
+}
+
+#if (defined(INTERRUPT_CONTROL_ENDPOINT) || defined(INTERRUPT_HID_ENDPOINT)) && defined(USB_CAN_BE_DEVICE)
 ISR(USB_COM_vect, ISR_BLOCK)
 {
 	uint8_t PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
 
-	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
-	USB_INT_Disable(USB_INT_RXSTPI);
+	#if defined(INTERRUPT_HID_ENDPOINT)
+	uint8_t EndpointInterrupts = (Endpoint_GetEndpointInterrupts() & ~(1 << ENDPOINT_CONTROLEP));
+
+	if (EndpointInterrupts)
+	{
+		EVENT_USB_Device_EndpointInterrupt(EndpointInterrupts);
+		Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+	}
+	#endif
+
+	#if defined(INTERRUPT_CONTROL_ENDPOINT)
+	if (Endpoint_HasEndpointInterrupted(ENDPOINT_CONTROLEP))
+	{
+		Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+
+		#if defined(ASYNC_CONTROL_TRANSFERS)
+		if (!(Endpoint_IsSETUPReceived()))
+		{
+			/* Bank or status stage event of a transfer in progress, advance it without re-enabling interrupts. */
+			Endpoint_Continue_Control_Stream();
+		}
+		else
+		#endif
+		{
+			#if defined(ASYNC_CONTROL_TRANSFERS)
+			Endpoint_Abort_Control_Stream();
+			#endif
+
+			USB_INT_Disable(USB_INT_RXSTPI);
 
-	GlobalInterruptEnable();
+			GlobalInterruptEnable();
 
-	USB_Device_ProcessControlRequest();
+			USB_Device_ProcessControlRequest();
 
-	Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
-	USB_INT_Enable(USB_INT_RXSTPI);
-	Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+			#if defined(ASYNC_CONTROL_TRANSFERS)
+			/* Send the first packet of a transfer started by the request, and arm its interrupts. */
+			GlobalInterruptDisable();
+			Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+			Endpoint_Continue_Control_Stream();
+			#endif
+
+			Endpoint_SelectEndpoint(ENDPOINT_CONTROLEP);
+			USB_INT_Enable(USB_INT_RXSTPI);
+		}
+
+		Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+	}
+	#endif
 }
 #endif
 
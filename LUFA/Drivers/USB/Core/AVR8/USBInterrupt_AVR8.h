@@ -71,6 +71,8 @@
 				USB_INT_EORSTI  = 4,
 				USB_INT_SOFI    = 5,
 				USB_INT_RXSTPI  = 6,
+				USB_INT_TXINI   = 14,
+				USB_INT_RXOUTI  = 15,
 				#endif
 				#if (defined(USB_CAN_BE_HOST) || defined(__DOXYGEN__))
 				USB_INT_HSOFI   = 7,
@@ -115,6 +117,12 @@
 					case USB_INT_RXSTPI:
 						UEIENX |= (1 << RXSTPE);
 						break;
+					case USB_INT_TXINI:
+						UEIENX |= (1 << TXINE);
+						break;
+					case USB_INT_RXOUTI:
+						UEIENX |= (1 << RXOUTE);
+						break;
 					#endif
 					#if defined(USB_CAN_BE_HOST)
 					case USB_INT_HSOFI:
@@ -175,6 +183,12 @@
 					case USB_INT_RXSTPI:
 						UEIENX &= ~(1 << RXSTPE);
 						break;
+					case USB_INT_TXINI:
+						UEIENX &= ~(1 << TXINE);
+						break;
+					case USB_INT_RXOUTI:
+						UEIENX &= ~(1 << RXOUTE);
+						break;
 					#endif
 					#if defined(USB_CAN_BE_HOST)
 					case USB_INT_HSOFI:
@@ -235,6 +249,12 @@
 					case USB_INT_RXSTPI:
 						UEINTX &= ~(1 << RXSTPI);
 						break;
+					case USB_INT_TXINI:
+						UEINTX &= ~(1 << TXINI);
+						break;
+					case USB_INT_RXOUTI:
+						UEINTX &= ~(1 << RXOUTI);
+						break;
 					#endif
 					#if defined(USB_CAN_BE_HOST)
 					case USB_INT_HSOFI:
@@ -288,6 +308,10 @@
 						return (UDIEN  & (1 << SOFE));
 					case USB_INT_RXSTPI:
 						return (UEIENX & (1 << RXSTPE));
+					case USB_INT_TXINI:
+						return (UEIENX & (1 << TXINE));
+					case USB_INT_RXOUTI:
+						return (UEIENX & (1 << RXOUTE));
 					#endif
 					#if defined(USB_CAN_BE_HOST)
 					case USB_INT_HSOFI:
@@ -334,6 +358,10 @@
 						return (UDINT  & (1 << SOFI));
 					case USB_INT_RXSTPI:
 						return (UEINTX & (1 << RXSTPI));
+					case USB_INT_TXINI:
+						return (UEINTX & (1 << TXINI));
+					case USB_INT_RXOUTI:
+						return (UEINTX & (1 << RXOUTI));
 					#endif
 					#if defined(USB_CAN_BE_HOST)
 					case USB_INT_HSOFI:
@@ -364,6 +392,10 @@
 		/* Function Prototypes: */
 			void USB_INT_ClearAllInterrupts(void);
 			void USB_INT_DisableAllInterrupts(void);
+
+			#if defined(DEFERRED_USB_EVENTS) && defined(USB_CAN_BE_DEVICE)
+			void USB_INT_ProcessDeferredEvents(void);
+			#endif
 	#endif
 
 	/* Disable C linkage for C++ Compilers: */
@@ -48,6 +48,8 @@ bool    USB_Device_RemoteWakeupEnabled;
 
 void USB_Device_ProcessControlRequest(void)
 {
+	USB_TRACE_ENTER(USB_TRACE_CONTROL_REQUEST);
+
 	#if defined(ARCH_BIG_ENDIAN)
 	USB_ControlRequest.bmRequestType = Endpoint_Read_8();
 	USB_ControlRequest.bRequest      = Endpoint_Read_8();
@@ -120,6 +122,8 @@ void USB_Device_ProcessControlRequest(void)
 		Endpoint_ClearSETUP();
 		Endpoint_StallTransaction();
 	}
+
+	USB_TRACE_LEAVE(USB_TRACE_CONTROL_REQUEST);
 }
 
 static void USB_Device_SetAddress(void)
@@ -216,8 +220,25 @@ static void USB_Device_GetConfiguration(void)
 }
 
 #if !defined(NO_INTERNAL_SERIAL) && (USE_INTERNAL_SERIAL != NO_DESCRIPTOR)
+#if defined(USB_DEVICE_CACHE_INTERNAL_SERIAL)
+static struct
+{
+	USB_Descriptor_Header_t Header;
+	uint16_t                UnicodeString[INTERNAL_SERIAL_LENGTH_BITS / 4];
+} SignatureDescriptor;
+
+void USB_Device_CacheInternalSerial(void)
+{
+	SignatureDescriptor.Header.Type = DTYPE_String;
+	SignatureDescriptor.Header.Size = USB_STRING_LEN(INTERNAL_SERIAL_LENGTH_BITS / 4);
+
+	USB_Device_GetSerialString(SignatureDescriptor.UnicodeString);
+}
+#endif
+
 static void USB_Device_GetInternalSerialDescriptor(void)
 {
+	#if !defined(USB_DEVICE_CACHE_INTERNAL_SERIAL)
 	struct
 	{
 		USB_Descriptor_Header_t Header;
@@ -228,11 +249,16 @@ static void USB_Device_GetInternalSerialDescriptor(void)
 	SignatureDescriptor.Header.Size = USB_STRING_LEN(INTERNAL_SERIAL_LENGTH_BITS / 4);
 
 	USB_Device_GetSerialString(SignatureDescriptor.UnicodeString);
+	#endif
 
 	Endpoint_ClearSETUP();
 
+	#if defined(ASYNC_CONTROL_TRANSFERS) && defined(USB_DEVICE_CACHE_INTERNAL_SERIAL)
+	Endpoint_Start_Control_Stream_LE(&SignatureDescriptor, sizeof(SignatureDescriptor), MEMSPACE_RAM);
+	#else
 	Endpoint_Write_Control_Stream_LE(&SignatureDescriptor, sizeof(SignatureDescriptor));
 	Endpoint_ClearOUT();
+	#endif
 }
 #endif
 
@@ -267,7 +293,17 @@ static void USB_Device_GetDescriptor(void)
 
 	Endpoint_ClearSETUP();
 
-	#if defined(USE_RAM_DESCRIPTORS) || !defined(ARCH_HAS_MULTI_ADDRESS_SPACE)
+	#if defined(ASYNC_CONTROL_TRANSFERS)
+	#if defined(USE_RAM_DESCRIPTORS)
+	Endpoint_Start_Control_Stream_LE(DescriptorPointer, DescriptorSize, MEMSPACE_RAM);
+	#elif defined(USE_EEPROM_DESCRIPTORS)
+	Endpoint_Start_Control_Stream_LE(DescriptorPointer, DescriptorSize, MEMSPACE_EEPROM);
+	#elif defined(USE_FLASH_DESCRIPTORS)
+	Endpoint_Start_Control_Stream_LE(DescriptorPointer, DescriptorSize, MEMSPACE_FLASH);
+	#else
+	Endpoint_Start_Control_Stream_LE(DescriptorPointer, DescriptorSize, DescriptorAddressSpace);
+	#endif
+	#elif defined(USE_RAM_DESCRIPTORS) || !defined(ARCH_HAS_MULTI_ADDRESS_SPACE)
 	Endpoint_Write_Control_Stream_LE(DescriptorPointer, DescriptorSize);
 	#elif defined(USE_EEPROM_DESCRIPTORS)
 	Endpoint_Write_Control_EStream_LE(DescriptorPointer, DescriptorSize);
@@ -282,7 +318,9 @@ static void USB_Device_GetDescriptor(void)
 	  Endpoint_Write_Control_Stream_LE(DescriptorPointer, DescriptorSize);
 	#endif
 
+	#if !defined(ASYNC_CONTROL_TRANSFERS)
 	Endpoint_ClearOUT();
+	#endif
 }
 
 static void USB_Device_GetStatus(void)
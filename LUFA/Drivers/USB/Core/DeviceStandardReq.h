@@ -132,9 +132,22 @@
 			#error Only one of the USE_*_DESCRIPTORS modes should be selected.
 		#endif
 
+		#if defined(ASYNC_CONTROL_TRANSFERS) && (ARCH != ARCH_AVR8)
+			#error ASYNC_CONTROL_TRANSFERS is only available on the AVR8 architecture.
+		#endif
+
+		/* Macros: */
+			#if !defined(NO_INTERNAL_SERIAL) && (USE_INTERNAL_SERIAL != NO_DESCRIPTOR) && !defined(NO_INTERNAL_SERIAL_CACHE)
+				#define USB_DEVICE_CACHE_INTERNAL_SERIAL
+			#endif
+
 		/* Function Prototypes: */
 			void USB_Device_ProcessControlRequest(void);
 
+			#if defined(USB_DEVICE_CACHE_INTERNAL_SERIAL)
+				void USB_Device_CacheInternalSerial(void);
+			#endif
+
 			#if defined(__INCLUDE_FROM_DEVICESTDREQ_C)
 				static void USB_Device_SetAddress(void);
 				static void USB_Device_SetConfiguration(void);
@@ -325,8 +325,71 @@
 			 *        \ref Group_USBManagement documentation).
 			 */
 			void EVENT_USB_Device_StartOfFrame(void);
+
+			/** Event for data endpoint interrupts, when enabled. This event fires from the USB endpoint interrupt when
+			 *  an endpoint other than the control endpoint has one of its endpoint interrupts enabled and pending,
+			 *  such as \ref USB_INT_TXINI on an IN endpoint whose bank was just freed by the host. The handler must
+			 *  clear or disable the pending interrupt on each endpoint, or the event will fire again as soon as it
+			 *  returns. The currently selected endpoint is restored by the library after the event.
+			 *
+			 *  This event is time-critical; it runs with global interrupts disabled.
+			 *
+			 *  \param[in] EndpointMask  Mask whose bits indicate which endpoints have interrupted, as returned by
+			 *                           \ref Endpoint_GetEndpointInterrupts().
+			 *
+			 *  \pre This event only exists if the \c INTERRUPT_HID_ENDPOINT token is passed to the compiler via the
+			 *       -D switch.
+			 *       \n\n
+			 *
+			 *  \note This event does not exist if the \c USB_HOST_ONLY token is supplied to the compiler (see
+			 *        \ref Group_USBManagement documentation).
+			 */
+			void EVENT_USB_Device_EndpointInterrupt(const uint8_t EndpointMask);
 		#endif
 
+		/* Enums: */
+			/** Enum for the hot path trace points of the library, passed to \ref CALLBACK_USB_TracePoint(). */
+			enum USB_TracePoints_t
+			{
+				USB_TRACE_GENERAL_ISR     = 0, /**< USB general interrupt (\c USB_GEN_vect on the AVR8 architecture). */
+				USB_TRACE_CONTROL_REQUEST = 1, /**< Processing of a control request by \ref USB_Device_ProcessControlRequest(). */
+				USB_TRACE_HID_TASK        = 2, /**< HID class device task, once a report opportunity is found. */
+				USB_TRACE_CREATE_REPORT   = 3, /**< Call of \ref CALLBACK_HID_Device_CreateHIDReport() by the HID class driver. */
+				USB_TRACE_APPLICATION     = 0x10, /**< First trace point free for use by the application. */
+				USB_TRACE_EXIT            = 0x80, /**< Mask OR'ed into a trace point when leaving it. */
+			};
+
+		/* Macros: */
+			#if defined(TRACE_HOT_PATHS) || defined(__DOXYGEN__)
+				/** Records the entry of a trace point through \ref CALLBACK_USB_TracePoint(). This compiles to nothing
+				 *  unless the \c TRACE_HOT_PATHS token is passed to the compiler via the -D switch.
+				 *
+				 *  \param[in] Point  Trace point entered, a value from \ref USB_TracePoints_t.
+				 */
+				#define USB_TRACE_ENTER(Point)    CALLBACK_USB_TracePoint(Point)
+
+				/** Records the exit of a trace point through \ref CALLBACK_USB_TracePoint(). This compiles to nothing
+				 *  unless the \c TRACE_HOT_PATHS token is passed to the compiler via the -D switch.
+				 *
+				 *  \param[in] Point  Trace point left, a value from \ref USB_TracePoints_t.
+				 */
+				#define USB_TRACE_LEAVE(Point)    CALLBACK_USB_TracePoint((Point) | USB_TRACE_EXIT)
+			#else
+				#define USB_TRACE_ENTER(Point)    do { } while (0)
+				#define USB_TRACE_LEAVE(Point)    do { } while (0)
+			#endif
+
+		/* Function Prototypes: */
+			#if defined(TRACE_HOT_PATHS) || defined(__DOXYGEN__)
+				/** Trace callback, which must be provided by the application when the \c TRACE_HOT_PATHS token is passed
+				 *  to the compiler. It is called on entry and exit of each library hot path, possibly from an interrupt,
+				 *  and should timestamp and store the trace point as quickly as possible.
+				 *
+				 *  \param[in] Point  Trace point, a value from \ref USB_TracePoints_t, OR'ed with \ref USB_TRACE_EXIT on exit.
+				 */
+				void CALLBACK_USB_TracePoint(const uint8_t Point);
+			#endif
+
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
@@ -357,6 +420,7 @@
 					void EVENT_USB_Device_WakeUp(void) ATTR_WEAK ATTR_ALIAS(USB_Event_Stub);
 					void EVENT_USB_Device_Reset(void) ATTR_WEAK ATTR_ALIAS(USB_Event_Stub);
 					void EVENT_USB_Device_StartOfFrame(void) ATTR_WEAK ATTR_ALIAS(USB_Event_Stub);
+					void EVENT_USB_Device_EndpointInterrupt(const uint8_t EndpointMask) ATTR_WEAK ATTR_ALIAS(USB_Event_Stub);
 				#endif
 			#endif
 	#endif
@@ -165,6 +165,10 @@ static void USB_Init_Device(void)
 	USB_Device_CurrentlySelfPowered = false;
 	#endif
 
+	#if defined(USB_DEVICE_CACHE_INTERNAL_SERIAL)
+	USB_Device_CacheInternalSerial();
+	#endif
+
 	#if !defined(FIXED_CONTROL_ENDPOINT_SIZE)
 	USB_Descriptor_Device_t* DeviceDescriptorPtr;
 
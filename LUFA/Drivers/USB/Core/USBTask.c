@@ -60,6 +60,10 @@ void USB_USBTask(void)
 #if defined(USB_CAN_BE_DEVICE)
 static void USB_DeviceTask(void)
 {
+	#if defined(DEFERRED_USB_EVENTS)
+	USB_INT_ProcessDeferredEvents();
+	#endif
+
 	if (USB_DeviceState == DEVICE_STATE_Unattached)
 	  return;
 
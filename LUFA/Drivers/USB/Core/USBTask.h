@@ -164,7 +164,10 @@
 			 *      \ref EVENT_USB_Host_DeviceEnumerationFailed() events.
 			 *
 			 *  If in device mode (only), the control endpoint can instead be managed via interrupts entirely by the library
-			 *  by defining the INTERRUPT_CONTROL_ENDPOINT token and passing it to the compiler via the -D switch.
+			 *  by defining the INTERRUPT_CONTROL_ENDPOINT token and passing it to the compiler via the -D switch. Likewise,
+			 *  the HID class driver services its report IN endpoint from the endpoint interrupt if the INTERRUPT_HID_ENDPOINT
+			 *  token is defined, with the application forwarding \ref EVENT_USB_Device_EndpointInterrupt() to
+			 *  \ref HID_Device_ProcessEndpointInterrupt().
 			 *
 			 *  \see \ref Group_Events for more information on the USB events.
 			 *
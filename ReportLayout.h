@@ -0,0 +1,44 @@
+/** \file
+ *
+ *  Macros declaring a HID report once, as a list of fields, and expanding the list into both the
+ *  report descriptor items and a matching packed report structure. A field list is a macro taking
+ *  the name of an expansion macro, and calling it once per field, from the first bit sent:
+ *
+ *  \code
+ *  #define MY_REPORT_FIELDS(FIELD) \
+ *      FIELD(MY_REPORT, uint8_t, Buttons, 1, 8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE, \
+ *            (HID_RI_USAGE_PAGE(8, 0x09), HID_RI_USAGE_MINIMUM(8, 1), HID_RI_USAGE_MAXIMUM(8, 8), ))
+ *  \endcode
+ *
+ *  Each field gives the prefix of its offset constants, the C type holding it, its name, its HID report
+ *  size and count, its main item flags, and its global and local items between parentheses, each
+ *  followed by a comma.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _REPORT_LAYOUT_H_
+#define _REPORT_LAYOUT_H_
+
+	/* Includes: */
+		#include "LUFA/Drivers/USB/USB.h"
+
+	/* Macros: */
+		/** Remove the parentheses around a list of items. */
+		#define REPORT_LAYOUT_UNPAREN(...)   __VA_ARGS__
+
+		/** Expand a field into the descriptor items of an input report. */
+		#define REPORT_LAYOUT_INPUT(Prefix, Type, Name, Size, Count, Flags, Items) \
+			REPORT_LAYOUT_UNPAREN Items \
+			HID_RI_REPORT_SIZE(8, Size), HID_RI_REPORT_COUNT(8, Count), HID_RI_INPUT(8, Flags),
+
+		/** Expand a field into a member of the report structure. A field wider than its type does not compile. */
+		#define REPORT_LAYOUT_MEMBER(Prefix, Type, Name, Size, Count, Flags, Items) \
+			Type Name : (Size) * (Count);
+
+		/** Expand a field into enumerators: Prefix_BIT_Name is the bit offset of the field in the report. The
+		 *  enumerator following the last field is the total number of bits.
+		 */
+		#define REPORT_LAYOUT_OFFSET(Prefix, Type, Name, Size, Count, Flags, Items) \
+			Prefix##_BIT_##Name, Prefix##_LAST_BIT_##Name = Prefix##_BIT_##Name + (Size) * (Count) - 1,
+
+#endif
@@ -0,0 +1,87 @@
+/** \file
+ *
+ *  Resolution of simultaneous opposing cardinal directions (SOCD). Each axis is resolved
+ *  with two table lookups and no branches on the direction state.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <avr/pgmspace.h>
+#include "Socd.h"
+
+#define N SOCD_VALUE_NEGATIVE
+#define Z SOCD_VALUE_NEUTRAL
+#define P SOCD_VALUE_POSITIVE
+
+/** Axis value indexed by [policy][axis][last pressed was positive][direction bits]. */
+static const uint8_t PROGMEM resolveTable[SOCD_NUM_POLICIES][2][2][4] =
+{
+	[SOCD_NEUTRAL] =
+		{
+			{ { Z, N, P, Z }, { Z, N, P, Z } },
+			{ { Z, N, P, Z }, { Z, N, P, Z } },
+		},
+	[SOCD_LAST_WINS] =
+		{
+			{ { Z, N, P, N }, { Z, N, P, P } },
+			{ { Z, N, P, N }, { Z, N, P, P } },
+		},
+	[SOCD_FIRST_WINS] =
+		{
+			{ { Z, N, P, P }, { Z, N, P, N } },
+			{ { Z, N, P, P }, { Z, N, P, N } },
+		},
+	[SOCD_UP_PRIORITY] =
+		{
+			{ { Z, N, P, Z }, { Z, N, P, Z } },
+			{ { Z, N, P, P }, { Z, N, P, P } },
+		},
+};
+
+/** Direction pressed last, indexed by [previous value][newly pressed direction bits]. A press of
+ *  both directions in the same sample keeps the previous value.
+ */
+static const uint8_t PROGMEM lastTable[2][4] =
+{
+	{ 0, 0, 1, 0 },
+	{ 1, 0, 1, 1 },
+};
+
+#undef N
+#undef Z
+#undef P
+
+static uint8_t socdPolicy = SOCD_UP_PRIORITY;
+
+/** Select the resolution policy. Unknown policies are ignored. */
+void Socd_SetPolicy(const uint8_t Policy)
+{
+	if (Policy < SOCD_NUM_POLICIES) {
+		socdPolicy = Policy;
+	}
+}
+
+/** Current resolution policy, as Socd_Policy_t. */
+uint8_t Socd_GetPolicy(void)
+{
+	return socdPolicy;
+}
+
+/** Resolve the directions pressed on an axis into the axis value to report.
+ *
+ *  \param[in,out] Axis   Direction history of the axis, updated on every call
+ *  \param[in]     Index  Axis being resolved, as the up priority policy only applies to Y
+ *  \param[in]     State  Direction bits pressed, \ref SOCD_NEGATIVE and \ref SOCD_POSITIVE
+ *
+ *  \return Axis value, one of \ref SOCD_VALUE_NEGATIVE, \ref SOCD_VALUE_NEUTRAL or \ref SOCD_VALUE_POSITIVE
+ */
+uint8_t Socd_Resolve(Socd_Axis_t* const Axis, const Socd_AxisIndex_t Index, const uint8_t State)
+{
+	uint8_t state = State & (SOCD_NEGATIVE | SOCD_POSITIVE);
+	uint8_t pressed = state & ~Axis->PrevState;
+
+	Axis->LastPositive = pgm_read_byte(&lastTable[Axis->LastPositive][pressed]);
+	Axis->PrevState = state;
+
+	return pgm_read_byte(&resolveTable[socdPolicy][Index][Axis->LastPositive][state]);
+}
+
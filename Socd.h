@@ -0,0 +1,54 @@
+/** \file
+ *
+ *  Header file for Socd.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SOCD_H_
+#define _SOCD_H_
+
+	/* Includes: */
+		#include <stdint.h>
+
+	/* Macros: */
+		/** Direction bits of an axis state, as given to Socd_Resolve(). */
+		#define SOCD_NEGATIVE                (1 << 0) /**< Left or down pressed. */
+		#define SOCD_POSITIVE                (1 << 1) /**< Right or up pressed. */
+
+		/** Axis values reported for each resolved direction. */
+		#define SOCD_VALUE_NEGATIVE          0
+		#define SOCD_VALUE_NEUTRAL           128
+		#define SOCD_VALUE_POSITIVE          255
+
+	/* Type Defines: */
+		/** Simultaneous opposing cardinal direction (SOCD) resolution policies. */
+		typedef enum
+		{
+			SOCD_NEUTRAL = 0, /**< Opposing directions cancel out on both axes. */
+			SOCD_LAST_WINS, /**< The most recently pressed direction wins. */
+			SOCD_FIRST_WINS, /**< The direction held first wins. */
+			SOCD_UP_PRIORITY, /**< Left and right cancel out, up wins over down. */
+			SOCD_NUM_POLICIES
+		} Socd_Policy_t;
+
+		/** Joystick axes. */
+		typedef enum
+		{
+			SOCD_AXIS_X = 0,
+			SOCD_AXIS_Y
+		} Socd_AxisIndex_t;
+
+		/** Direction history of one axis, needed by the last and first wins policies. */
+		typedef struct
+		{
+			uint8_t PrevState; /**< Direction bits seen in the previous call. */
+			uint8_t LastPositive; /**< 1 if the positive direction was pressed last, 0 if the negative one was. */
+		} Socd_Axis_t;
+
+	/* Function Prototypes: */
+		void Socd_SetPolicy(const uint8_t Policy);
+		uint8_t Socd_GetPolicy(void);
+		uint8_t Socd_Resolve(Socd_Axis_t* const Axis, const Socd_AxisIndex_t Index, const uint8_t State);
+
+#endif
+
@@ -0,0 +1,152 @@
+/** \file
+ *
+ *  Hot path tracing. The USB library reports entry and exit of its hot paths through
+ *  CALLBACK_USB_TracePoint(), which timestamps them with Timer3 counting CPU cycles into a RAM
+ *  ring. The host reads the ring with a vendor control request, and the longest USB general
+ *  interrupt, which blocks every other interrupt while it runs, as measured by the library on
+ *  Timer3 (USB_ISR_TIMER=TCNT3). Everything compiles to nothing unless TRACE_HOT_PATHS is defined.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <avr/io.h>
+#include "LUFA/Drivers/USB/USB.h"
+#include "Trace.h"
+
+#if defined(TRACE_HOT_PATHS)
+
+_Static_assert(sizeof(Trace_Event_t) == 3, "Trace events are not laid out as sent to the host");
+
+/** Ring of trace events. */
+static Trace_Event_t ring[TRACE_RING_SIZE];
+
+/** Next slot written. */
+static uint8_t head;
+
+/** Events held in the ring, oldest at head - count. */
+static uint8_t count;
+
+#if defined(ASYNC_CONTROL_TRANSFERS)
+/** Data stage of the vendor request being answered, sent after Trace_ProcessControlRequest() returns. */
+static union {
+	Trace_Event_t events[TRACE_READ_MAX];
+	uint16_t cycles;
+} reply;
+#endif
+
+/** Start Timer3 as a free running cycle counter. It wraps every 4 ms at 16 MHz, so events are
+ *  timed relative to their neighbours.
+ */
+void Trace_Init(void)
+{
+	TCCR3A = 0;
+	TCCR3B = (1 << CS30);
+}
+
+/** Store a trace point in the ring, overwriting the oldest event if it is full. Called by the USB
+ *  library, possibly from an interrupt.
+ *
+ *  \param[in] Point  Trace point reached
+ */
+void CALLBACK_USB_TracePoint(const uint8_t Point)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+
+	uint16_t timestamp;
+
+	GlobalInterruptDisable();
+	timestamp = TCNT3;
+	ring[head].Timestamp = timestamp;
+	ring[head].Point = Point;
+	head = (head + 1) & (TRACE_RING_SIZE - 1);
+	if (count < TRACE_RING_SIZE) {
+		++count;
+	}
+	SetGlobalInterruptMask(CurrentGlobalInt);
+}
+
+/** Remove the oldest events from the ring.
+ *
+ *  \param[out] Events  Buffer for the events, oldest first
+ *  \param[in]  Count   Largest number of events to read
+ *
+ *  \return Number of events read
+ */
+uint8_t Trace_Read(Trace_Event_t* const Events, const uint8_t Count)
+{
+	uint_reg_t CurrentGlobalInt = GetGlobalInterruptMask();
+	uint8_t i, n, tail;
+
+	GlobalInterruptDisable();
+	n = MIN(Count, count);
+	tail = (head - count) & (TRACE_RING_SIZE - 1);
+	for (i = 0; i < n; ++i) {
+		Events[i] = ring[tail];
+		tail = (tail + 1) & (TRACE_RING_SIZE - 1);
+	}
+	count -= n;
+	SetGlobalInterruptMask(CurrentGlobalInt);
+	return n;
+}
+
+/** Longest USB general interrupt seen, as measured by the library. The interrupt runs with
+ *  interrupts disabled, so this bounds the latency it adds to every other interrupt, short of the
+ *  register saving and restoring around its body.
+ *
+ *  \param[in] Reset  Start a new measurement after reading
+ *
+ *  \return Longest interrupt in CPU cycles
+ */
+uint16_t Trace_WorstISRCycles(const bool Reset)
+{
+	return USB_Device_GetWorstISRTime(Reset);
+}
+
+/** Answer \ref TRACE_REQUEST_READ vendor requests with as many of the oldest events as fit in
+ *  the requested length, and \ref TRACE_REQUEST_WORST_ISR requests. Should be linked to the EVENT_USB_Device_ControlRequest() event.
+ */
+void Trace_ProcessControlRequest(void)
+{
+	#if defined(ASYNC_CONTROL_TRANSFERS)
+	Trace_Event_t* events = reply.events;
+	#else
+	Trace_Event_t events[TRACE_READ_MAX];
+	#endif
+	uint8_t n;
+
+	if (!Endpoint_IsSETUPReceived()) {
+		return;
+	}
+	if (USB_ControlRequest.bmRequestType != (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE)) {
+		return;
+	}
+	if (USB_ControlRequest.bRequest == TRACE_REQUEST_WORST_ISR) {
+		#if defined(ASYNC_CONTROL_TRANSFERS)
+		reply.cycles = Trace_WorstISRCycles(true);
+
+		Endpoint_ClearSETUP();
+		Endpoint_Start_Control_Stream_LE(&reply.cycles, sizeof(reply.cycles), MEMSPACE_RAM);
+		#else
+		uint16_t cycles = Trace_WorstISRCycles(true);
+
+		Endpoint_ClearSETUP();
+		Endpoint_Write_Control_Stream_LE(&cycles, sizeof(cycles));
+		Endpoint_ClearOUT();
+		#endif
+		return;
+	}
+	if (USB_ControlRequest.bRequest != TRACE_REQUEST_READ) {
+		return;
+	}
+
+	n = Trace_Read(events, MIN(TRACE_READ_MAX, USB_ControlRequest.wLength / sizeof(Trace_Event_t)));
+
+	Endpoint_ClearSETUP();
+	#if defined(ASYNC_CONTROL_TRANSFERS)
+	Endpoint_Start_Control_Stream_LE(events, n * sizeof(Trace_Event_t), MEMSPACE_RAM);
+	#else
+	Endpoint_Write_Control_Stream_LE(events, n * sizeof(Trace_Event_t));
+	Endpoint_ClearOUT();
+	#endif
+}
+
+#endif
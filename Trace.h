@@ -0,0 +1,52 @@
+/** \file
+ *
+ *  Header file for Trace.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+	/* Includes: */
+		#include <stdbool.h>
+		#include <stdint.h>
+
+		#include "LUFA/Common/Common.h"
+
+	/* Macros: */
+		/** Number of events held in the trace ring, a power of two. Older events are overwritten. */
+		#define TRACE_RING_SIZE              64
+
+		/** Vendor device-to-host control request reading and removing the oldest trace events. */
+		#define TRACE_REQUEST_READ           0x01
+
+		/** Largest number of events returned by a single \ref TRACE_REQUEST_READ request. */
+		#define TRACE_READ_MAX               16
+
+		/** Vendor device-to-host control request reading the longest USB general interrupt seen, in CPU
+		 *  cycles as a 16-bit little endian value, and restarting the measurement. */
+		#define TRACE_REQUEST_WORST_ISR      0x02
+
+	/* Preprocessor Checks: */
+		#if defined(TRACE_HOT_PATHS) && !defined(USB_ISR_TIMER)
+			#error TRACE_HOT_PATHS requires USB_ISR_TIMER, which must be defined to TCNT3, the Timer3 count started by Trace_Init().
+		#endif
+
+	/* Type Defines: */
+		/** Trace event, as stored in the ring and sent to the host, 3 bytes with the timestamp little endian. */
+		typedef struct
+		{
+			uint8_t  Point; /**< Trace point, a USB_TracePoints_t value OR'ed with USB_TRACE_EXIT on exit. */
+			uint16_t Timestamp; /**< Timer3 count, in CPU cycles, when the point was reached. */
+		} ATTR_PACKED Trace_Event_t;
+
+	/* Function Prototypes: */
+		#if defined(TRACE_HOT_PATHS)
+		void Trace_Init(void);
+		uint8_t Trace_Read(Trace_Event_t* const Events, const uint8_t Count);
+		uint16_t Trace_WorstISRCycles(const bool Reset);
+		void Trace_ProcessControlRequest(void);
+		#endif
+
+#endif
+
@@ -0,0 +1,135 @@
+/** \file
+ *
+ *  Turbo (auto-fire) timing. Each rate has a single phase, derived from the USB frame number and
+ *  shared by all buttons set to that rate, so they stay phase-locked. A button pressed in the
+ *  released half of its rate is reported pressed in the first report created after the press,
+ *  then follows the shared phase. Half periods are longer than the endpoint polling interval, so
+ *  each toggle is seen by the host in its own report.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <avr/pgmspace.h>
+#include "Turbo.h"
+
+/** USB frame numbers are 11 bits wide. */
+#define FRAME_NUMBER_MASK            0x07FF
+
+/** Frames in each half period, indexed by rate - 1. */
+static const uint8_t PROGMEM halfPeriods[TURBO_NUM_RATES] = { 17, 25, 33, 50 };
+
+/** Buttons using each rate, indexed by rate - 1. */
+static uint16_t rateMasks[TURBO_NUM_RATES];
+
+/** Frames left in the current half period of each rate. */
+static uint8_t countdown[TURBO_NUM_RATES];
+
+/** Bit n is set while rate n + 1 is in the released half of its period. */
+static uint8_t phaseOff;
+
+/** Frame number of the previous tick, valid once \ref frameSynced is set. */
+static uint16_t prevFrame;
+static bool frameSynced;
+
+/** Pressed buttons seen by the previous tick, to find press edges. */
+static uint16_t pressedMask;
+
+/** Buttons pressed in the released half of their rate, not reported yet. */
+static uint16_t forceOn;
+
+/** Buttons to report as released in the current frame. */
+static uint16_t offMask;
+
+/** Set the turbo rate of each button, and restart all rates in phase from the next tick.
+ *
+ *  \param[in] Rates  Turbo_Rate_t of each button, unknown values turn turbo off
+ *  \param[in] Count  Number of buttons, up to \ref TURBO_MAX_BUTTONS
+ */
+void Turbo_SetRates(const uint8_t* const Rates, const uint8_t Count)
+{
+	uint8_t i;
+
+	for (i = 0; i < TURBO_NUM_RATES; ++i) {
+		rateMasks[i] = 0;
+		countdown[i] = pgm_read_byte(&halfPeriods[i]);
+	}
+	for (i = 0; i < Count && i < TURBO_MAX_BUTTONS; ++i) {
+		if (Rates[i] != TURBO_OFF && Rates[i] <= TURBO_NUM_RATES) {
+			rateMasks[Rates[i] - 1] |= (1 << i);
+		}
+	}
+	phaseOff = 0;
+	frameSynced = false;
+	forceOn = 0;
+	offMask = 0;
+}
+
+/** Read back the turbo rate of each button.
+ *
+ *  \param[out] Rates  Turbo_Rate_t of each button
+ *  \param[in]  Count  Number of buttons, up to \ref TURBO_MAX_BUTTONS
+ */
+void Turbo_GetRates(uint8_t* const Rates, const uint8_t Count)
+{
+	uint8_t i, rate;
+
+	for (i = 0; i < Count && i < TURBO_MAX_BUTTONS; ++i) {
+		Rates[i] = TURBO_OFF;
+		for (rate = 0; rate < TURBO_NUM_RATES; ++rate) {
+			if (rateMasks[rate] & (1 << i)) {
+				Rates[i] = rate + 1;
+			}
+		}
+	}
+}
+
+/** Advance the turbo phases to the given frame. Should be called on every start of frame, after
+ *  the inputs are debounced. Frames missed in between, such as while suspended, are caught up.
+ *
+ *  \param[in] FrameNumber  Current USB frame number
+ *  \param[in] Pressed      Debounced pressed buttons
+ *
+ *  \return Boolean \c true if the pressed buttons to report as released changed
+ */
+bool Turbo_Tick(const uint16_t FrameNumber, const uint16_t Pressed)
+{
+	uint16_t elapsed = frameSynced ? ((FrameNumber - prevFrame) & FRAME_NUMBER_MASK) : 0;
+	uint16_t mask = 0;
+	bool changed;
+	uint8_t i;
+
+	prevFrame = FrameNumber;
+	frameSynced = true;
+
+	for (i = 0; i < TURBO_NUM_RATES; ++i) {
+		uint16_t frames = elapsed;
+
+		while (frames >= countdown[i]) {
+			frames -= countdown[i];
+			countdown[i] = pgm_read_byte(&halfPeriods[i]);
+			phaseOff ^= (1 << i);
+		}
+		countdown[i] -= frames;
+		if (phaseOff & (1 << i)) {
+			mask |= rateMasks[i];
+		}
+	}
+
+	/* A press landing in the released half is not swallowed: it shows in one report first. */
+	forceOn |= mask & Pressed & ~pressedMask;
+	forceOn &= Pressed;
+	pressedMask = Pressed;
+
+	mask &= Pressed & ~forceOn;
+	changed = (mask != offMask);
+	offMask = mask;
+	return changed;
+}
+
+/** Buttons that must be reported as released in the report being created. Creating a report
+ *  consumes the pending forced presses, so those buttons join their rate's phase on the next tick.
+ */
+uint16_t Turbo_GetOffMask(void)
+{
+	forceOn = 0;
+	return offMask;
+}
@@ -0,0 +1,39 @@
+/** \file
+ *
+ *  Header file for Turbo.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _TURBO_H_
+#define _TURBO_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+	/* Macros: */
+		/** Number of turbo rates, not counting \ref TURBO_OFF. */
+		#define TURBO_NUM_RATES              4
+
+		/** Largest number of buttons with turbo settings. */
+		#define TURBO_MAX_BUTTONS            16
+
+	/* Type Defines: */
+		/** Turbo rates, as stored for each button. */
+		typedef enum
+		{
+			TURBO_OFF = 0, /**< Button reported as pressed. */
+			TURBO_30HZ, /**< Toggles every 17 frames, about 30 presses per second. */
+			TURBO_20HZ, /**< Toggles every 25 frames. */
+			TURBO_15HZ, /**< Toggles every 33 frames, about 15 presses per second. */
+			TURBO_10HZ, /**< Toggles every 50 frames. */
+		} Turbo_Rate_t;
+
+	/* Function Prototypes: */
+		void Turbo_SetRates(const uint8_t* const Rates, const uint8_t Count);
+		void Turbo_GetRates(uint8_t* const Rates, const uint8_t Count);
+		bool Turbo_Tick(const uint16_t FrameNumber, const uint16_t Pressed);
+		uint16_t Turbo_GetOffMask(void);
+
+#endif
+
@@ -0,0 +1,120 @@
+/** \file
+ *
+ *  The "make sim" program: boots the firmware against the scripted host, enumerates it, presses and
+ *  releases a button while the joystick endpoint is polled every frame, then prints the bus
+ *  transcript and what each firmware path cost.
+ *
+ *  Costs are counted in accesses to the modelled USB and I/O registers and bytes moved through
+ *  UEDATX, which follow the AVR code closely, plus host time spent in firmware code. They compare
+ *  paths and builds with each other; AVR cycles still have to be measured on the device, with
+ *  TRACE_HOT_PATHS (see Trace.h).
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+
+#include "LUFA/Drivers/USB/USB.h"
+#include "Host.h"
+
+int Firmware_Main(void);
+
+/** Declares the cost counter of a firmware path, and the --wrap stub that fills it in. */
+#define COST_PATH(Path, Return, Parameters, Arguments)       \
+	static Sim_Cost_t Cost_##Path = {.Name = #Path};         \
+	Return __real_##Path Parameters;                         \
+	Return __wrap_##Path Parameters;                         \
+	Return __wrap_##Path Parameters                          \
+	{                                                        \
+		Sim_CostEnter(&Cost_##Path);                         \
+		Return Result = __real_##Path Arguments;             \
+		Sim_CostLeave(&Cost_##Path);                         \
+		return Result;                                       \
+	}
+
+#define COST_PATH_VOID(Path, Parameters, Arguments)          \
+	static Sim_Cost_t Cost_##Path = {.Name = #Path};         \
+	void __real_##Path Parameters;                           \
+	void __wrap_##Path Parameters;                           \
+	void __wrap_##Path Parameters                            \
+	{                                                        \
+		Sim_CostEnter(&Cost_##Path);                         \
+		__real_##Path Arguments;                             \
+		Sim_CostLeave(&Cost_##Path);                         \
+	}
+
+COST_PATH_VOID(EVENT_USB_Device_StartOfFrame, (void), ())
+COST_PATH_VOID(USB_Device_ProcessControlRequest, (void), ())
+COST_PATH_VOID(HID_Device_USBTask, (USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo), (HIDInterfaceInfo))
+COST_PATH_VOID(HID_Device_ProcessControlRequest, (USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo),
+               (HIDInterfaceInfo))
+COST_PATH(CALLBACK_USB_GetDescriptor, uint16_t,
+          (const uint16_t wValue, const uint16_t wIndex, const void** const DescriptorAddress),
+          (wValue, wIndex, DescriptorAddress))
+COST_PATH(CALLBACK_HID_Device_CreateHIDReport, bool,
+          (USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo, uint8_t* const ReportID, const uint8_t ReportType,
+           void* ReportData, uint16_t* const ReportSize),
+          (HIDInterfaceInfo, ReportID, ReportType, ReportData, ReportSize))
+
+static const Sim_Cost_t* Costs[] =
+{
+	NULL,
+	NULL,
+	&Cost_EVENT_USB_Device_StartOfFrame,
+	&Cost_USB_Device_ProcessControlRequest,
+	&Cost_CALLBACK_USB_GetDescriptor,
+	&Cost_HID_Device_USBTask,
+	&Cost_HID_Device_ProcessControlRequest,
+	&Cost_CALLBACK_HID_Device_CreateHIDReport,
+};
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+static void PrintCosts(void)
+{
+	Costs[0] = Sim_InterruptCost(false);
+	Costs[1] = Sim_InterruptCost(true);
+
+	printf("\n%-36s %7s %9s %9s %9s %9s\n", "path", "calls", "acc/call", "max acc", "bytes", "ns/call");
+
+	for (uint8_t Path = 0; Path < sizeof(Costs) / sizeof(Costs[0]); Path++)
+	{
+		const Sim_Cost_t* Cost = Costs[Path];
+
+		if (!(Cost->Calls))
+		  continue;
+
+		printf("%-36s %7u %9.1f %9u %9u %9.0f\n", Cost->Name, Cost->Calls,
+		       (double)Cost->Accesses / Cost->Calls, Cost->MaxAccesses, Cost->Bytes,
+		       (double)Cost->Nanoseconds / Cost->Calls);
+	}
+
+	printf("\nacc: accesses to modelled registers, bytes: moved through UEDATX, ns: host time outside the\n"
+	       "model. Nested paths are included in their callers. These compare paths and builds only, AVR\n"
+	       "cycles have to be measured on the device with TRACE_HOT_PATHS.\n");
+}
+
+int main(void)
+{
+	Host_SetTranscript(stdout);
+	printf("frame  token ep  data\n");
+
+	Host_Boot(Firmware);
+	Host_Enumerate();
+	Host_PollInterrupt(ENDPOINT_DIR_IN | 1, 1);
+
+	Sim_RunFrames(10);
+	printf("-- press button 1\n");
+	Sim_SetPins(SIM_PINB, (1 << 5), true);
+	Sim_RunFrames(10);
+	printf("-- release button 1\n");
+	Sim_SetPins(SIM_PINB, (1 << 5), false);
+	Sim_RunFrames(10);
+
+	PrintCosts();
+	return Host_Failures() ? 1 : 0;
+}
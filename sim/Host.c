@@ -0,0 +1,312 @@
+/** \file
+ *
+ *  Scripted USB host for the simulator. Transfers are written as plain sequential code: each
+ *  transaction is retried, letting the firmware run between tries, until the device answers it.
+ *  An interrupt IN endpoint can also be polled on every few frames in the background, as the
+ *  host controller of a PC would, while control transfers are in progress.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <string.h>
+#include <avr/io.h>
+
+#include "Host.h"
+
+/** Reports the interrupt endpoint poller keeps until read. Must be a power of two. */
+#define HOST_REPORT_QUEUE_SIZE       256
+
+static FILE*         Transcript;
+static uint8_t       PollEndpoint;
+static uint8_t       PollInterval;
+static Host_Report_t Reports[HOST_REPORT_QUEUE_SIZE];
+static uint16_t      ReportsHead;
+static uint16_t      ReportsCount;
+static int           Failures;
+
+static void Log(const char* const Token, const uint8_t Endpoint, const void* const Data, const int16_t Length)
+{
+	if (!Transcript)
+	  return;
+
+	fprintf(Transcript, "%5u  %-5s ep%u ", Sim_HostFrameNumber(), Token, Endpoint & 0x0F);
+
+	switch (Length)
+	{
+		case SIM_NAK:
+			fprintf(Transcript, " NAK");
+			break;
+		case SIM_STALL:
+			fprintf(Transcript, " STALL");
+			break;
+		case SIM_NO_RESPONSE:
+			fprintf(Transcript, " no response");
+			break;
+		case HOST_TIMEOUT:
+			fprintf(Transcript, " timeout");
+			break;
+		case 0:
+			fprintf(Transcript, " ZLP");
+			break;
+		default:
+			for (int16_t Byte = 0; Byte < Length; Byte++)
+			  fprintf(Transcript, " %02x", ((const uint8_t*)Data)[Byte]);
+			break;
+	}
+
+	fprintf(Transcript, "\n");
+}
+
+static void PollFrame(const uint16_t FrameNumber)
+{
+	uint8_t Data[HOST_MAX_REPORT];
+
+	if (!PollInterval || (FrameNumber % PollInterval))
+	  return;
+
+	int16_t Length = Sim_HostIn(PollEndpoint, Data, sizeof(Data));
+
+	if (Length < 0)
+	  return;
+
+	Log("IN", PollEndpoint, Data, Length);
+
+	Host_Report_t* Report = &Reports[(ReportsHead + ReportsCount) % HOST_REPORT_QUEUE_SIZE];
+
+	if (ReportsCount == HOST_REPORT_QUEUE_SIZE)
+	  ReportsHead = (ReportsHead + 1) % HOST_REPORT_QUEUE_SIZE;
+	else
+	  ReportsCount++;
+
+	Report->Frame  = FrameNumber;
+	Report->Length = Length;
+	memcpy(Report->Data, Data, Length);
+}
+
+static bool DeviceAttached(void)
+{
+	return (Sim_Peek(SIM_USBCON) & (1 << USBE)) && !(Sim_Peek(SIM_UDCON) & (1 << DETACH));
+}
+
+/** Waits for the next start of frame, as a PC host schedules the next transfer. */
+static void NextFrame(void)
+{
+	uint16_t Frame = Sim_HostFrameNumber();
+
+	while (Sim_HostFrameNumber() == Frame)
+	  Sim_Step();
+}
+
+/** Prints every transaction to \c Stream, or nothing if NULL. */
+void Host_SetTranscript(FILE* const Stream)
+{
+	Transcript = Stream;
+}
+
+/** Starts the firmware, plugs it in and resets the bus once it attached. */
+void Host_Boot(void (*const Firmware)(void))
+{
+	Sim_SetFrameHook(PollFrame);
+	Sim_Start(Firmware);
+	Sim_HostAttach();
+
+	if (!Sim_RunUntil(DeviceAttached, 2000UL * SIM_STEPS_PER_FRAME))
+	  Host_Expect(false, "device attaches to the bus");
+
+	Sim_HostReset();
+
+	/* Reset recovery time, before the first SETUP. */
+	Sim_RunFrames(10);
+	Host_Expect(Sim_HostIsConfigured(0), "device configures its control endpoint after a bus reset");
+}
+
+/** Sends IN tokens until the device answers with data or a STALL. */
+int16_t Host_WaitIn(const uint8_t Endpoint, void* const Data, const uint8_t MaxLength)
+{
+	for (uint32_t Step = 0; Step < HOST_TIMEOUT_FRAMES * SIM_STEPS_PER_FRAME; Step++)
+	{
+		int16_t Length = Sim_HostIn(Endpoint, Data, MaxLength);
+
+		if (Length != SIM_NAK)
+		{
+			Log("IN", Endpoint, Data, Length);
+			return Length;
+		}
+
+		Sim_Step();
+	}
+
+	Log("IN", Endpoint, NULL, HOST_TIMEOUT);
+	return HOST_TIMEOUT;
+}
+
+/** Sends an OUT packet until the device acknowledges it or answers with a STALL. */
+int16_t Host_WaitOut(const uint8_t Endpoint, const void* const Data, const uint8_t Length)
+{
+	for (uint32_t Step = 0; Step < HOST_TIMEOUT_FRAMES * SIM_STEPS_PER_FRAME; Step++)
+	{
+		int16_t Sent = Sim_HostOut(Endpoint, Data, Length);
+
+		if (Sent != SIM_NAK)
+		{
+			Log("OUT", Endpoint, Data, Sent);
+			return Sent;
+		}
+
+		Sim_Step();
+	}
+
+	Log("OUT", Endpoint, NULL, HOST_TIMEOUT);
+	return HOST_TIMEOUT;
+}
+
+/** Runs a control transfer with a device to host data stage. \c Data needs room for
+ *  \c wLength bytes plus a packet, so a device sending too much is caught.
+ *
+ *  \return Bytes received, or a negative error.
+ */
+int16_t Host_ControlRead(const Host_Request_t* const Request, void* const Data)
+{
+	uint8_t* Bytes = Data;
+	int16_t  Total = 0;
+	int16_t  Length;
+
+	Log("SETUP", 0, Request, sizeof(Host_Request_t));
+	Sim_HostSetup(0, Request);
+
+	do
+	{
+		Length = Host_WaitIn(0, &Bytes[Total], HOST_CONTROL_SIZE);
+
+		if (Length < 0)
+		  return Length;
+
+		Total += Length;
+	}
+	while ((Length == HOST_CONTROL_SIZE) && (Total < Request->wLength));
+
+	Host_Expect(Total <= Request->wLength, "device sends no more than wLength bytes");
+
+	if ((Length = Host_WaitOut(0, NULL, 0)) < 0)
+	  return Length;
+
+	NextFrame();
+	return Total;
+}
+
+/** Runs a control transfer with a host to device data stage, or none if \c wLength is zero.
+ *
+ *  \return Bytes sent, or a negative error.
+ */
+int16_t Host_ControlWrite(const Host_Request_t* const Request, const void* const Data)
+{
+	const uint8_t* Bytes = Data;
+	uint8_t        Status[HOST_CONTROL_SIZE];
+	int16_t        Length;
+
+	Log("SETUP", 0, Request, sizeof(Host_Request_t));
+	Sim_HostSetup(0, Request);
+
+	for (uint16_t Total = 0; Total < Request->wLength; Total += Length)
+	{
+		Length = Request->wLength - Total;
+
+		if (Length > HOST_CONTROL_SIZE)
+		  Length = HOST_CONTROL_SIZE;
+
+		if ((Length = Host_WaitOut(0, &Bytes[Total], Length)) < 0)
+		  return Length;
+	}
+
+	Length = Host_WaitIn(0, Status, sizeof(Status));
+
+	if (Length < 0)
+	  return Length;
+
+	Host_Expect(Length == 0, "status stage of a control write is a ZLP");
+
+	NextFrame();
+	return Request->wLength;
+}
+
+static bool AddressEnabled(void)
+{
+	return Sim_HostAddress() != 0;
+}
+
+/** Enumerates the device as a PC would: reads its descriptors, gives it an address and selects
+ *  its first configuration.
+ */
+bool Host_Enumerate(void)
+{
+	uint8_t Data[512];
+	bool    Success = true;
+
+	const Host_Request_t GetDevice  = {0x80, 0x06, 0x0100, 0x0000, 64};
+	const Host_Request_t SetAddress = {0x00, 0x05, 0x0005, 0x0000, 0};
+	const Host_Request_t GetConfig  = {0x80, 0x06, 0x0200, 0x0000, 9};
+	const Host_Request_t GetLang    = {0x80, 0x06, 0x0300, 0x0000, 255};
+	const Host_Request_t GetProduct = {0x80, 0x06, 0x0302, 0x0409, 255};
+	const Host_Request_t SetConfig  = {0x00, 0x09, 0x0001, 0x0000, 0};
+	const Host_Request_t SetIdle    = {0x21, 0x0A, 0x0000, 0x0000, 0};
+
+	Success &= (Host_ControlRead(&GetDevice, Data) == 18);
+	Success &= (Host_ControlWrite(&SetAddress, NULL) == 0);
+	Success &= Sim_RunUntil(AddressEnabled, HOST_TIMEOUT_FRAMES * SIM_STEPS_PER_FRAME);
+	Success &= (Host_ControlRead(&GetConfig, Data) == 9);
+
+	Host_Request_t GetFullConfig = GetConfig;
+	GetFullConfig.wLength = Data[2] | (Data[3] << 8);
+	Success &= (Host_ControlRead(&GetFullConfig, Data) == GetFullConfig.wLength);
+
+	/* The HID descriptor follows the interface descriptor, its report descriptor length is at offset 7. */
+	Host_Request_t GetReport = {0x81, 0x06, 0x2200, 0x0000, Data[9 + 9 + 7] | (Data[9 + 9 + 8] << 8)};
+
+	Success &= (Host_ControlRead(&GetLang, Data) > 0);
+	Success &= (Host_ControlRead(&GetProduct, Data) > 0);
+	Success &= (Host_ControlWrite(&SetConfig, NULL) == 0);
+	Success &= (Host_ControlWrite(&SetIdle, NULL) == 0);
+	Success &= (Host_ControlRead(&GetReport, Data) == GetReport.wLength);
+
+	Host_Expect(Success, "device enumerates");
+	return Success;
+}
+
+/** Polls an interrupt IN endpoint every \c IntervalFrames frames, or stops polling if zero. */
+void Host_PollInterrupt(const uint8_t Endpoint, const uint8_t IntervalFrames)
+{
+	PollEndpoint = Endpoint;
+	PollInterval = IntervalFrames;
+}
+
+/** Takes the oldest report read by the interrupt endpoint poller, if any. */
+bool Host_NextReport(Host_Report_t* const Report)
+{
+	if (!ReportsCount)
+	  return false;
+
+	*Report     = Reports[ReportsHead];
+	ReportsHead = (ReportsHead + 1) % HOST_REPORT_QUEUE_SIZE;
+	ReportsCount--;
+	return true;
+}
+
+void Host_ClearReports(void)
+{
+	ReportsCount = 0;
+}
+
+/** Records a failed check, printing what was expected. */
+void Host_Expect(const bool Condition, const char* const What)
+{
+	if (Condition)
+	  return;
+
+	printf("FAIL: %s\n", What);
+	Failures++;
+}
+
+int Host_Failures(void)
+{
+	return Failures;
+}
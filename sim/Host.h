@@ -0,0 +1,74 @@
+/** \file
+ *
+ *  Header file for Host.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _HOST_H_
+#define _HOST_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+		#include <stdio.h>
+
+		#include "Simulator.h"
+
+	/* Enable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			extern "C" {
+		#endif
+
+	/* Macros: */
+		/** Size of the device control endpoint. */
+		#define HOST_CONTROL_SIZE            8
+
+		/** Frames the host waits for a handshake before giving up on a transfer. */
+		#define HOST_TIMEOUT_FRAMES          50
+
+		/** Returned by the transfers when the device does not answer in \ref HOST_TIMEOUT_FRAMES. */
+		#define HOST_TIMEOUT                 -4
+
+		/** Longest report the interrupt endpoint poller keeps. */
+		#define HOST_MAX_REPORT              64
+
+	/* Type Defines: */
+		/** Standard control request, as sent in the SETUP packet. */
+		typedef struct
+		{
+			uint8_t  bmRequestType;
+			uint8_t  bRequest;
+			uint16_t wValue;
+			uint16_t wIndex;
+			uint16_t wLength;
+		} __attribute__((packed)) Host_Request_t;
+
+		/** Report received by the interrupt endpoint poller. */
+		typedef struct
+		{
+			uint16_t Frame; /**< Frame the report was read in. */
+			uint8_t  Length; /**< Bytes in the report, including its ID. */
+			uint8_t  Data[HOST_MAX_REPORT]; /**< Report data. */
+		} Host_Report_t;
+
+	/* Function Prototypes: */
+		void Host_SetTranscript(FILE* const Stream);
+		void Host_Boot(void (*const Firmware)(void));
+		bool Host_Enumerate(void);
+		int16_t Host_ControlRead(const Host_Request_t* const Request, void* const Data);
+		int16_t Host_ControlWrite(const Host_Request_t* const Request, const void* const Data);
+		int16_t Host_WaitIn(const uint8_t Endpoint, void* const Data, const uint8_t MaxLength);
+		int16_t Host_WaitOut(const uint8_t Endpoint, const void* const Data, const uint8_t Length);
+		void Host_PollInterrupt(const uint8_t Endpoint, const uint8_t IntervalFrames);
+		bool Host_NextReport(Host_Report_t* const Report);
+		void Host_ClearReports(void);
+		void Host_Expect(const bool Condition, const char* const What);
+		int Host_Failures(void);
+
+	/* Disable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			}
+		#endif
+
+#endif
+
@@ -0,0 +1,1003 @@
+/** \file
+ *
+ *  Host model of the ATmega32U4 USB device controller, to run the firmware and the LUFA library
+ *  on a PC. The firmware runs as a coroutine that hands the bus over to the host on every access
+ *  to a modelled register, so the host can answer busy-wait loops with SETUP, IN and OUT tokens
+ *  like a real one would. Interrupt handlers run in the firmware coroutine, whenever their
+ *  interrupt is enabled, pending and the I bit of SREG is set.
+ *
+ *  Register writes are applied lazily: each access remembers the value it returned, and the next
+ *  access compares it with what the firmware left in the register to see which bits were cleared
+ *  or set. This keeps the firmware code untouched, as it only sees volatile registers.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/time.h>
+
+#include <avr/io.h>
+
+#include "Simulator.h"
+
+/* Interrupt handlers, defined by the firmware with ISR(). USB_COM_vect is only built with
+ * INTERRUPT_CONTROL_ENDPOINT. */
+void USB_GEN_vect(void);
+void USB_COM_vect(void) __attribute__((weak));
+
+/** Size of the firmware coroutine stack. */
+#define FIRMWARE_STACK_SIZE          (256 * 1024)
+
+/** Timer1 ticks per frame at clk/64, and Timer3 ticks per frame at clk/1. */
+#define TIMER1_TICKS_PER_FRAME       250
+#define TIMER3_TICKS_PER_FRAME       16000
+
+/** UEINTX flags latched by the model and cleared by the firmware. */
+#define LATCHED_FLAGS                ((1 << NAKINI) | (1 << NAKOUTI) | (1 << RXSTPI) | (1 << RXOUTI) | \
+                                      (1 << STALLEDI) | (1 << TXINI))
+
+/** UDINT flags raised by the host. */
+#define DEVICE_FLAGS                 ((1 << UPRSMI) | (1 << EORSMI) | (1 << WAKEUPI) | (1 << EORSTI) | \
+                                      (1 << SOFI) | (1 << SUSPI))
+
+typedef struct
+{
+	uint8_t Config0; /**< UECFG0X. */
+	uint8_t Config1; /**< UECFG1X. */
+	uint8_t Enabled; /**< UECONX EPEN bit. */
+	uint8_t IntEnable; /**< UEIENX. */
+	uint8_t Flags; /**< Latched UEINTX flags. */
+	bool    Stalled; /**< Set with STALLRQ, cleared with STALLRQC or a SETUP. */
+	uint8_t InBank[2][SIM_MAX_BANK_SIZE]; /**< Banks holding data for the host. */
+	uint8_t InLength[2]; /**< Bytes in each committed bank. */
+	uint8_t InBusy; /**< Committed banks waiting for an IN token, NBUSYBK. */
+	uint8_t InHead; /**< Oldest committed bank, sent on the next IN token. */
+	uint8_t InFill; /**< Bytes written to the bank being filled. */
+	uint8_t Out[SIM_MAX_BANK_SIZE]; /**< Bank holding the last SETUP or OUT packet. */
+	uint8_t OutLength; /**< Bytes in the received packet. */
+	uint8_t OutRead; /**< Bytes of the received packet already read by the firmware. */
+} Sim_Endpoint_t;
+
+typedef struct
+{
+	bool     Is16; /**< Access to a 16-bit register. */
+	uint8_t  Register; /**< Sim_Register_t or Sim_Register16_t. */
+	uint8_t  Endpoint; /**< Endpoint selected at the time of the access. */
+	bool     Write; /**< UEDATX access that writes to the bank. */
+	uint16_t Returned; /**< Register value handed to the firmware. */
+} Sim_Access_t;
+
+static volatile uint8_t  Registers[SIM_NUM_REGISTERS];
+static volatile uint16_t Registers16[SIM_NUM_REGISTERS16];
+static Sim_Endpoint_t    Endpoints[SIM_MAX_ENDPOINTS];
+static Sim_Access_t      LastAccess;
+static bool              AccessPending;
+
+static uint8_t  DeviceFlags; /**< Pending UDINT flags. */
+static bool     VbusFlag; /**< Pending USBINT VBUSTI flag. */
+static bool     VbusPresent;
+static bool     BusActive; /**< Host sends start of frame packets. */
+static uint16_t FrameNumber;
+static uint16_t Timer1Base;
+static uint16_t Timer3Base;
+static uint32_t StepInFrame;
+static uint8_t  PinsPressed[4]; /**< Pressed inputs of PINB to PINE, read as low levels. */
+
+static bool     SleepEnabled;
+static bool     Sleeping;
+static uint8_t  InterruptDepth;
+
+static ucontext_t HostContext;
+static ucontext_t FirmwareContext;
+static void     (*FirmwareEntry)(void);
+static bool     InFirmware;
+static bool     FirmwareStarted;
+static uint32_t Steps;
+static volatile uint32_t WatchdogSteps;
+static void     (*FrameHook)(uint16_t FrameNumber);
+
+static Sim_Cost_t GeneralInterruptCost  = {.Name = "USB_GEN_vect"};
+static Sim_Cost_t EndpointInterruptCost = {.Name = "USB_COM_vect"};
+
+static uint32_t Accesses;
+static uint32_t Bytes;
+static uint64_t ModelNanoseconds;
+static uint64_t ModelEntered;
+static uint8_t  ModelDepth;
+
+static uint64_t Now(void)
+{
+	struct timespec Time;
+
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (uint64_t)Time.tv_sec * 1000000000u + Time.tv_nsec;
+}
+
+/** Marks time spent in the model, which Sim_FirmwareNanoseconds() leaves out. */
+static void ModelEnter(void)
+{
+	if (!(ModelDepth++))
+	  ModelEntered = Now();
+}
+
+static void ModelLeave(void)
+{
+	if (!(--ModelDepth))
+	  ModelNanoseconds += Now() - ModelEntered;
+}
+
+static void Fail(const char* const Message)
+{
+	fprintf(stderr, "sim: %s\n", Message);
+	abort();
+}
+
+static void Watchdog(int Signal)
+{
+	static uint32_t LastSteps;
+	static uint8_t  StuckSeconds;
+	static const char Message[] = "sim: firmware ran for 5 s without touching a register\n";
+
+	(void)Signal;
+
+	if (!InFirmware || (WatchdogSteps != LastSteps))
+	{
+		LastSteps    = WatchdogSteps;
+		StuckSeconds = 0;
+		return;
+	}
+
+	if (++StuckSeconds == 5)
+	{
+		if (write(STDERR_FILENO, Message, sizeof(Message) - 1) < 0)
+		  _exit(2);
+		_exit(2);
+	}
+}
+
+static uint8_t EndpointSize(const Sim_Endpoint_t* const Endpoint)
+{
+	return 8 << ((Endpoint->Config1 >> EPSIZE0) & 0x07);
+}
+
+static uint8_t EndpointBanks(const Sim_Endpoint_t* const Endpoint)
+{
+	return (Endpoint->Config1 & (1 << EPBK0)) ? 2 : 1;
+}
+
+static bool EndpointIsControl(const Sim_Endpoint_t* const Endpoint)
+{
+	return !(Endpoint->Config0 >> EPTYPE0);
+}
+
+static bool EndpointIsIN(const Sim_Endpoint_t* const Endpoint)
+{
+	return (Endpoint->Config0 & (1 << EPDIR)) != 0;
+}
+
+static bool EndpointIsAllocated(const Sim_Endpoint_t* const Endpoint)
+{
+	return Endpoint->Enabled && (Endpoint->Config1 & (1 << ALLOC));
+}
+
+static bool EndpointHasOutData(const Sim_Endpoint_t* const Endpoint)
+{
+	return (Endpoint->Flags & ((1 << RXSTPI) | (1 << RXOUTI))) && (Endpoint->OutRead < Endpoint->OutLength);
+}
+
+static void EndpointResetFIFO(Sim_Endpoint_t* const Endpoint)
+{
+	Endpoint->Flags     = 0;
+	Endpoint->InBusy    = 0;
+	Endpoint->InHead    = 0;
+	Endpoint->InFill    = 0;
+	Endpoint->OutLength = 0;
+	Endpoint->OutRead   = 0;
+
+	if (EndpointIsIN(Endpoint))
+	  Endpoint->Flags |= (1 << TXINI);
+}
+
+/** Sends the bank being filled, like clearing FIFOCON (or TXINI on a control endpoint). */
+static void EndpointCommit(Sim_Endpoint_t* const Endpoint)
+{
+	uint8_t Banks = EndpointBanks(Endpoint);
+
+	if (Endpoint->InBusy == Banks)
+	  return;
+
+	Endpoint->InLength[(Endpoint->InHead + Endpoint->InBusy) % Banks] = Endpoint->InFill;
+	Endpoint->InBusy++;
+	Endpoint->InFill = 0;
+
+	if (!EndpointIsControl(Endpoint) && (Endpoint->InBusy < Banks))
+	  Endpoint->Flags |= (1 << TXINI);
+}
+
+/** Drops the last committed bank, like setting KILLBK. */
+static void EndpointKill(Sim_Endpoint_t* const Endpoint)
+{
+	if (!(Endpoint->InBusy))
+	  return;
+
+	Endpoint->InBusy--;
+	Endpoint->InFill = 0;
+	Endpoint->Flags |= (1 << TXINI);
+}
+
+static void EndpointWrite(Sim_Endpoint_t* const Endpoint, const uint8_t Data)
+{
+	uint8_t Banks = EndpointBanks(Endpoint);
+
+	if ((Endpoint->InBusy == Banks) || (Endpoint->InFill == EndpointSize(Endpoint)))
+	  return;
+
+	Endpoint->InBank[(Endpoint->InHead + Endpoint->InBusy) % Banks][Endpoint->InFill++] = Data;
+}
+
+static uint8_t EndpointUEINTX(const Sim_Endpoint_t* const Endpoint)
+{
+	uint8_t Value    = Endpoint->Flags & LATCHED_FLAGS;
+	bool    Writable = (Endpoint->InBusy < EndpointBanks(Endpoint));
+
+	if (EndpointIsControl(Endpoint))
+	{
+		Value &= ~(1 << TXINI);
+
+		if (!(Endpoint->InBusy))
+		  Value |= (1 << TXINI);
+	}
+	else if (EndpointIsIN(Endpoint))
+	{
+		if (Writable)
+		  Value |= (1 << FIFOCON);
+
+		if (Writable && (Endpoint->InFill < EndpointSize(Endpoint)))
+		  Value |= (1 << RWAL);
+	}
+	else
+	{
+		if (Endpoint->OutLength)
+		  Value |= (1 << FIFOCON);
+
+		if (Endpoint->OutRead < Endpoint->OutLength)
+		  Value |= (1 << RWAL);
+	}
+
+	return Value;
+}
+
+static bool EndpointInterruptPending(const Sim_Endpoint_t* const Endpoint)
+{
+	uint8_t Flags  = EndpointUEINTX(Endpoint);
+	uint8_t Enable = Endpoint->IntEnable;
+
+	return ((Flags & (1 << TXINI))    && (Enable & (1 << TXINE)))    ||
+	       ((Flags & (1 << STALLEDI)) && (Enable & (1 << STALLEDE))) ||
+	       ((Flags & (1 << RXOUTI))   && (Enable & (1 << RXOUTE)))   ||
+	       ((Flags & (1 << RXSTPI))   && (Enable & (1 << RXSTPE)))   ||
+	       ((Flags & (1 << NAKOUTI))  && (Enable & (1 << NAKOUTE)))  ||
+	       ((Flags & (1 << NAKINI))   && (Enable & (1 << NAKINE)));
+}
+
+static void SettleUEINTX(Sim_Endpoint_t* const Endpoint, const uint8_t Returned, const uint8_t Written)
+{
+	uint8_t Cleared = Returned & ~Written;
+	uint8_t Set     = Written & ~Returned;
+
+	if (EndpointIsControl(Endpoint))
+	{
+		if (Cleared & (1 << TXINI))
+		  EndpointCommit(Endpoint);
+
+		if (Cleared & ((1 << RXSTPI) | (1 << RXOUTI)))
+		{
+			Endpoint->OutLength = 0;
+			Endpoint->OutRead   = 0;
+		}
+
+		Endpoint->Flags &= ~(Cleared & LATCHED_FLAGS);
+	}
+	else if (EndpointIsIN(Endpoint))
+	{
+		if (Set & (1 << KILLBK))
+		  EndpointKill(Endpoint);
+
+		Endpoint->Flags &= ~(Cleared & LATCHED_FLAGS);
+
+		if (Cleared & (1 << FIFOCON))
+		  EndpointCommit(Endpoint);
+	}
+	else
+	{
+		Endpoint->Flags &= ~(Cleared & LATCHED_FLAGS);
+
+		if (Cleared & (1 << FIFOCON))
+		{
+			Endpoint->OutLength = 0;
+			Endpoint->OutRead   = 0;
+		}
+	}
+}
+
+/** Applies what the firmware did with the value handed out by the previous access. */
+static void Settle(void)
+{
+	if (!AccessPending)
+	  return;
+
+	AccessPending = false;
+
+	Sim_Access_t*   Access   = &LastAccess;
+	Sim_Endpoint_t* Endpoint = &Endpoints[Access->Endpoint];
+
+	if (Access->Is16)
+	{
+		uint16_t Written = Registers16[Access->Register];
+
+		if (Written == Access->Returned)
+		  return;
+
+		if (Access->Register == SIM_TCNT1)
+		  Timer1Base += Written - Access->Returned;
+		else if (Access->Register == SIM_TCNT3)
+		  Timer3Base += Written - Access->Returned;
+
+		return;
+	}
+
+	uint8_t Written  = Registers[Access->Register];
+	uint8_t Returned = Access->Returned;
+
+	switch (Access->Register)
+	{
+		case SIM_UDINT:
+			DeviceFlags &= ~(Returned & ~Written);
+			break;
+		case SIM_USBINT:
+			if ((Returned & ~Written) & (1 << VBUSTI))
+			  VbusFlag = false;
+			break;
+		case SIM_UERST:
+			for (uint8_t Number = 0; Number < SIM_MAX_ENDPOINTS; Number++)
+			{
+				if (Written & ~Returned & (1 << Number))
+				  EndpointResetFIFO(&Endpoints[Number]);
+			}
+			break;
+		case SIM_UECONX:
+			Endpoint->Enabled = Written & (1 << EPEN);
+
+			if (Written & (1 << STALLRQC))
+			  Endpoint->Stalled = false;
+			else if ((Written & ~Returned) & (1 << STALLRQ))
+			  Endpoint->Stalled = true;
+			break;
+		case SIM_UECFG0X:
+			Endpoint->Config0 = Written;
+			break;
+		case SIM_UECFG1X:
+			if ((Written & ~Endpoint->Config1) & (1 << ALLOC))
+			{
+				Endpoint->Config1 = Written;
+				EndpointResetFIFO(Endpoint);
+			}
+
+			Endpoint->Config1 = Written;
+			break;
+		case SIM_UEIENX:
+			Endpoint->IntEnable = Written;
+			break;
+		case SIM_UEINTX:
+			SettleUEINTX(Endpoint, Returned, Written);
+			break;
+		case SIM_UEDATX:
+			if (Access->Write)
+			{
+				EndpointWrite(Endpoint, Written);
+				Bytes++;
+			}
+			break;
+	}
+}
+
+/** Value the model shows for a register, from the state of the controller. */
+static uint8_t Compute(const Sim_Register_t Register, Sim_Endpoint_t* const Endpoint)
+{
+	switch (Register)
+	{
+		case SIM_USBSTA:
+			return (Registers[SIM_USBSTA] & ~(1 << VBUS)) | (VbusPresent ? (1 << VBUS) : 0);
+		case SIM_USBINT:
+			return VbusFlag ? (1 << VBUSTI) : 0;
+		case SIM_UDINT:
+			return DeviceFlags;
+		case SIM_UENUM:
+			return Registers[SIM_UENUM] & 0x07;
+		case SIM_UECONX:
+			return Endpoint->Enabled | (Endpoint->Stalled ? (1 << STALLRQ) : 0);
+		case SIM_UECFG0X:
+			return Endpoint->Config0;
+		case SIM_UECFG1X:
+			return Endpoint->Config1;
+		case SIM_UESTA0X:
+			return (EndpointIsAllocated(Endpoint) ? (1 << CFGOK) : 0) |
+			       (EndpointIsIN(Endpoint) || EndpointIsControl(Endpoint) ? Endpoint->InBusy : (Endpoint->OutLength != 0));
+		case SIM_UESTA1X:
+			return 0;
+		case SIM_UEINTX:
+			return EndpointUEINTX(Endpoint);
+		case SIM_UEIENX:
+			return Endpoint->IntEnable;
+		case SIM_UEBCLX:
+			return EndpointHasOutData(Endpoint) ? (Endpoint->OutLength - Endpoint->OutRead) : Endpoint->InFill;
+		case SIM_UEBCHX:
+			return 0;
+		case SIM_UEINT:
+		{
+			uint8_t Pending = 0;
+
+			for (uint8_t Number = 0; Number < SIM_MAX_ENDPOINTS; Number++)
+			{
+				if (EndpointInterruptPending(&Endpoints[Number]))
+				  Pending |= (1 << Number);
+			}
+
+			return Pending;
+		}
+		case SIM_PLLCSR:
+			return (Registers[SIM_PLLCSR] & ~(1 << PLOCK)) | ((Registers[SIM_PLLCSR] >> PLLE) & 1);
+		case SIM_PINB:
+		case SIM_PINC:
+		case SIM_PIND:
+		case SIM_PINE:
+			return ~PinsPressed[Register - SIM_PINB];
+		default:
+			return Registers[Register];
+	}
+}
+
+static bool GeneralInterruptPending(void)
+{
+	return (DeviceFlags & Registers[SIM_UDIEN] & DEVICE_FLAGS) ||
+	       (VbusFlag && (Registers[SIM_USBCON] & (1 << VBUSTE)));
+}
+
+static bool EndpointInterruptsPending(void)
+{
+	for (uint8_t Number = 0; Number < SIM_MAX_ENDPOINTS; Number++)
+	{
+		if (EndpointInterruptPending(&Endpoints[Number]))
+		  return true;
+	}
+
+	return false;
+}
+
+/** Runs the handlers of enabled pending interrupts, USB_GEN_vect first as it has the lower vector. */
+static bool Dispatch(void)
+{
+	bool Dispatched = false;
+
+	for (uint16_t Round = 0; Registers[SIM_SREG] & 0x80; Round++)
+	{
+		void       (*Handler)(void);
+		Sim_Cost_t* Cost;
+
+		if (GeneralInterruptPending())
+		{
+			Handler = USB_GEN_vect;
+			Cost    = &GeneralInterruptCost;
+		}
+		else if (USB_COM_vect && EndpointInterruptsPending())
+		{
+			Handler = USB_COM_vect;
+			Cost    = &EndpointInterruptCost;
+		}
+		else
+		{
+			break;
+		}
+
+		if (Round == 10000)
+		  Fail("interrupt storm, a handler does not clear its flag");
+
+		Registers[SIM_SREG] &= ~0x80;
+		InterruptDepth++;
+		ModelLeave();
+		Sim_CostEnter(Cost);
+		Handler();
+		Sim_CostLeave(Cost);
+		ModelEnter();
+		Settle();
+		InterruptDepth--;
+		Registers[SIM_SREG] |= 0x80;
+		Dispatched = true;
+	}
+
+	return Dispatched;
+}
+
+/** Hands the bus over to the host, when running as the firmware coroutine. */
+static void Yield(void)
+{
+	if (!InFirmware)
+	  return;
+
+	InFirmware = false;
+	swapcontext(&FirmwareContext, &HostContext);
+	InFirmware = true;
+}
+
+volatile uint8_t* Sim_IO(const Sim_Register_t Register)
+{
+	ModelEnter();
+	Settle();
+	WatchdogSteps++;
+	Accesses++;
+	Yield();
+	Dispatch();
+
+	uint8_t         Number   = Registers[SIM_UENUM] & 0x07;
+	Sim_Endpoint_t* Endpoint = &Endpoints[Number];
+	bool            Write    = false;
+	uint8_t         Value;
+
+	if (Register == SIM_UEDATX)
+	{
+		if (EndpointHasOutData(Endpoint))
+		{
+			Value = Endpoint->Out[Endpoint->OutRead++];
+			Bytes++;
+		}
+		else
+		{
+			Value = 0;
+			Write = true;
+		}
+	}
+	else
+	{
+		Value = Compute(Register, Endpoint);
+	}
+
+	Registers[Register] = Value;
+	LastAccess          = (Sim_Access_t){.Is16 = false, .Register = Register, .Endpoint = Number,
+	                                     .Write = Write, .Returned = Value};
+	AccessPending       = true;
+
+	ModelLeave();
+	return &Registers[Register];
+}
+
+volatile uint16_t* Sim_IO16(const Sim_Register16_t Register)
+{
+	ModelEnter();
+	Settle();
+	WatchdogSteps++;
+	Accesses++;
+	Yield();
+	Dispatch();
+
+	uint16_t Value = 0;
+	uint16_t Step  = StepInFrame;
+
+	switch (Register)
+	{
+		case SIM_UDFNUM:
+			Value = FrameNumber;
+			break;
+		case SIM_TCNT1:
+			Value = Timer1Base;
+
+			if ((Registers[SIM_TCCR1B] & 0x07) == ((1 << CS11) | (1 << CS10)))
+			  Value += (uint32_t)Step * TIMER1_TICKS_PER_FRAME / SIM_STEPS_PER_FRAME;
+			break;
+		case SIM_TCNT3:
+			Value = Timer3Base;
+
+			if ((Registers[SIM_TCCR3B] & 0x07) == (1 << CS30))
+			  Value += (uint32_t)Step * TIMER3_TICKS_PER_FRAME / SIM_STEPS_PER_FRAME;
+			break;
+		default:
+			break;
+	}
+
+	Registers16[Register] = Value;
+	LastAccess            = (Sim_Access_t){.Is16 = true, .Register = Register, .Returned = Value};
+	AccessPending         = true;
+
+	ModelLeave();
+	return &Registers16[Register];
+}
+
+void Sim_Sei(void)
+{
+	ModelEnter();
+	Settle();
+	Registers[SIM_SREG] |= 0x80;
+
+	/* As on the AVR, the instruction after SEI runs before pending interrupts, so the usual
+	 * sleep_enable(); sei(); sleep_cpu(); sequence cannot miss a wake up. */
+	if (!SleepEnabled)
+	  Dispatch();
+
+	ModelLeave();
+}
+
+void Sim_Cli(void)
+{
+	ModelEnter();
+	Settle();
+	Registers[SIM_SREG] &= ~0x80;
+	ModelLeave();
+}
+
+void Sim_SleepEnable(const bool Enable)
+{
+	SleepEnabled = Enable;
+
+	if (Enable)
+	  Registers[SIM_SMCR] |= (1 << SE);
+	else
+	  Registers[SIM_SMCR] &= ~(1 << SE);
+}
+
+void Sim_Sleep(void)
+{
+	ModelEnter();
+	Settle();
+
+	if (!SleepEnabled)
+	{
+		ModelLeave();
+		return;
+	}
+
+	if (!InFirmware)
+	  Fail("sleeping outside of the firmware coroutine");
+
+	Sleeping = true;
+
+	while (!((Registers[SIM_SREG] & 0x80) && (GeneralInterruptPending() || EndpointInterruptsPending())))
+	{
+		WatchdogSteps++;
+		Yield();
+	}
+
+	Sleeping = false;
+	Dispatch();
+	ModelLeave();
+}
+
+void Sim_DelayMicroseconds(const uint32_t Microseconds)
+{
+	uint32_t DelaySteps = (uint64_t)Microseconds * SIM_STEPS_PER_FRAME / 1000;
+
+	ModelEnter();
+	Settle();
+
+	while (DelaySteps--)
+	{
+		WatchdogSteps++;
+		Yield();
+	}
+
+	Dispatch();
+	ModelLeave();
+}
+
+uint8_t Sim_SignatureByte(const uint16_t Address)
+{
+	return 0x50 + Address;
+}
+
+static void FirmwareMain(void)
+{
+	FirmwareEntry();
+	Fail("firmware returned from its entry point");
+}
+
+/** Starts the firmware coroutine, which runs until its first register access. */
+void Sim_Start(void (*const Entry)(void))
+{
+	static uint8_t Stack[FIRMWARE_STACK_SIZE];
+	struct sigaction Action = {.sa_handler = Watchdog, .sa_flags = SA_RESTART};
+	struct itimerval Interval = {.it_interval = {1, 0}, .it_value = {1, 0}};
+
+	memset(Endpoints, 0, sizeof(Endpoints));
+	memset((void*)Registers, 0, sizeof(Registers));
+	Registers[SIM_MCUSR] = (1 << PORF);
+
+	FirmwareEntry = Entry;
+	getcontext(&FirmwareContext);
+	FirmwareContext.uc_stack.ss_sp   = Stack;
+	FirmwareContext.uc_stack.ss_size = sizeof(Stack);
+	FirmwareContext.uc_link          = &HostContext;
+	makecontext(&FirmwareContext, FirmwareMain, 0);
+	FirmwareStarted = true;
+
+	sigaction(SIGALRM, &Action, NULL);
+	setitimer(ITIMER_REAL, &Interval, NULL);
+
+	Sim_Step();
+}
+
+static void StartOfFrame(void)
+{
+	if (!BusActive)
+	  return;
+
+	FrameNumber  = (FrameNumber + 1) & 0x07FF;
+	DeviceFlags |= (1 << SOFI);
+
+	if (FrameHook)
+	  FrameHook(FrameNumber);
+}
+
+/** Lets the firmware run up to its next register access, then advances the bus clock by one step. */
+void Sim_Step(void)
+{
+	if (!FirmwareStarted)
+	  Fail("firmware not started");
+
+	InFirmware = true;
+	swapcontext(&HostContext, &FirmwareContext);
+	InFirmware = false;
+
+	Steps++;
+
+	if (++StepInFrame == SIM_STEPS_PER_FRAME)
+	{
+		StepInFrame = 0;
+
+		if ((Registers[SIM_TCCR1B] & 0x07) == ((1 << CS11) | (1 << CS10)))
+		  Timer1Base += TIMER1_TICKS_PER_FRAME;
+
+		if ((Registers[SIM_TCCR3B] & 0x07) == (1 << CS30))
+		  Timer3Base += TIMER3_TICKS_PER_FRAME;
+
+		StartOfFrame();
+	}
+}
+
+/** Steps the firmware until \c Done returns true, for at most \c MaxSteps steps. */
+bool Sim_RunUntil(bool (*const Done)(void), const uint32_t MaxSteps)
+{
+	for (uint32_t Step = 0; Step < MaxSteps; Step++)
+	{
+		if (Done())
+		  return true;
+
+		Sim_Step();
+	}
+
+	return Done();
+}
+
+void Sim_RunFrames(const uint16_t Frames)
+{
+	for (uint32_t Step = 0; Step < (uint32_t)Frames * SIM_STEPS_PER_FRAME; Step++)
+	  Sim_Step();
+}
+
+bool Sim_IsSleeping(void)
+{
+	return Sleeping;
+}
+
+uint32_t Sim_Steps(void)
+{
+	return Steps;
+}
+
+void Sim_SetFrameHook(void (*const Hook)(uint16_t FrameNumber))
+{
+	FrameHook = Hook;
+}
+
+/** Presses or releases the inputs of \c Mask on a port, given by its PINx register. */
+void Sim_SetPins(const Sim_Register_t Port, const uint8_t Mask, const bool Pressed)
+{
+	if (Pressed)
+	  PinsPressed[Port - SIM_PINB] |= Mask;
+	else
+	  PinsPressed[Port - SIM_PINB] &= ~Mask;
+}
+
+/** Last value of a register, without the side effects of a firmware access. */
+uint8_t Sim_Peek(const Sim_Register_t Register)
+{
+	return Registers[Register];
+}
+
+/** Plugs the device in, raising VBUS. */
+void Sim_HostAttach(void)
+{
+	VbusPresent = true;
+	VbusFlag    = true;
+}
+
+/** Drives a bus reset. Start of frame packets follow it. */
+void Sim_HostReset(void)
+{
+	for (uint8_t Number = 0; Number < SIM_MAX_ENDPOINTS; Number++)
+	{
+		Endpoints[Number].Config1 &= ~(1 << ALLOC);
+		Endpoints[Number].Enabled  = 0;
+	}
+
+	Registers[SIM_UDADDR] = 0;
+	DeviceFlags |= (1 << EORSTI);
+	BusActive    = true;
+}
+
+uint16_t Sim_HostFrameNumber(void)
+{
+	return FrameNumber;
+}
+
+/** Address the device answers to, or 0 before it enabled one. */
+uint8_t Sim_HostAddress(void)
+{
+	return (Registers[SIM_UDADDR] & (1 << ADDEN)) ? (Registers[SIM_UDADDR] & 0x7F) : 0;
+}
+
+static Sim_Endpoint_t* HostEndpoint(const uint8_t Number)
+{
+	Sim_Endpoint_t* Endpoint = &Endpoints[Number & 0x07];
+
+	Settle();
+	return EndpointIsAllocated(Endpoint) ? Endpoint : NULL;
+}
+
+/** Sends a SETUP packet to a control endpoint. It is always acknowledged. */
+int16_t Sim_HostSetup(const uint8_t Number, const void* const Data)
+{
+	Sim_Endpoint_t* Endpoint = HostEndpoint(Number);
+
+	if (!Endpoint)
+	  return SIM_NO_RESPONSE;
+
+	memcpy(Endpoint->Out, Data, 8);
+	Endpoint->OutLength = 8;
+	Endpoint->OutRead   = 0;
+	Endpoint->InBusy    = 0;
+	Endpoint->InHead    = 0;
+	Endpoint->InFill    = 0;
+	Endpoint->Stalled   = false;
+	Endpoint->Flags     = (Endpoint->Flags & ~((1 << RXOUTI) | (1 << STALLEDI))) | (1 << RXSTPI);
+	return 8;
+}
+
+/** Sends an OUT packet, returning its length once acknowledged, \ref SIM_NAK or \ref SIM_STALL. */
+int16_t Sim_HostOut(const uint8_t Number, const void* const Data, const uint8_t Length)
+{
+	Sim_Endpoint_t* Endpoint = HostEndpoint(Number);
+
+	if (!Endpoint)
+	  return SIM_NO_RESPONSE;
+
+	if (Endpoint->Stalled)
+	{
+		Endpoint->Flags |= (1 << STALLEDI);
+		return SIM_STALL;
+	}
+
+	if ((Endpoint->Flags & ((1 << RXSTPI) | (1 << RXOUTI))) || (Length > EndpointSize(Endpoint)))
+	{
+		Endpoint->Flags |= (1 << NAKOUTI);
+		return SIM_NAK;
+	}
+
+	memcpy(Endpoint->Out, Data, Length);
+	Endpoint->OutLength = Length;
+	Endpoint->OutRead   = 0;
+	Endpoint->Flags    |= (1 << RXOUTI);
+	return Length;
+}
+
+/** Sends an IN token, returning the length of the packet received, \ref SIM_NAK or \ref SIM_STALL. */
+int16_t Sim_HostIn(const uint8_t Number, void* const Data, const uint8_t MaxLength)
+{
+	Sim_Endpoint_t* Endpoint = HostEndpoint(Number);
+
+	if (!Endpoint)
+	  return SIM_NO_RESPONSE;
+
+	if (Endpoint->Stalled)
+	{
+		Endpoint->Flags |= (1 << STALLEDI);
+		return SIM_STALL;
+	}
+
+	if (!(Endpoint->InBusy))
+	{
+		Endpoint->Flags |= (1 << NAKINI);
+		return SIM_NAK;
+	}
+
+	uint8_t Length = Endpoint->InLength[Endpoint->InHead];
+
+	if (Length > MaxLength)
+	  Fail("IN packet longer than the host buffer");
+
+	memcpy(Data, Endpoint->InBank[Endpoint->InHead], Length);
+	Endpoint->InHead = (Endpoint->InHead + 1) % EndpointBanks(Endpoint);
+	Endpoint->InBusy--;
+
+	if (!EndpointIsControl(Endpoint))
+	  Endpoint->Flags |= (1 << TXINI);
+
+	return Length;
+}
+
+uint8_t Sim_HostBusyBanks(const uint8_t Number)
+{
+	Sim_Endpoint_t* Endpoint = HostEndpoint(Number);
+
+	return Endpoint ? Endpoint->InBusy : 0;
+}
+
+bool Sim_HostIsConfigured(const uint8_t Number)
+{
+	return HostEndpoint(Number) != NULL;
+}
+
+uint32_t Sim_Accesses(void)
+{
+	return Accesses;
+}
+
+uint32_t Sim_Bytes(void)
+{
+	return Bytes;
+}
+
+/** Costs of the USB interrupt handlers, or of the endpoint one if \c Endpoint is set. */
+const Sim_Cost_t* Sim_InterruptCost(const bool Endpoint)
+{
+	return Endpoint ? &EndpointInterruptCost : &GeneralInterruptCost;
+}
+
+/** Host time spent running firmware code, leaving out the model and the host. */
+uint64_t Sim_FirmwareNanoseconds(void)
+{
+	return Now() - ModelNanoseconds;
+}
+
+void Sim_CostEnter(Sim_Cost_t* const Cost)
+{
+	if (Cost->Depth++)
+	  return;
+
+	Cost->StartAccesses    = Accesses;
+	Cost->StartBytes       = Bytes;
+	Cost->StartNanoseconds = Sim_FirmwareNanoseconds();
+}
+
+void Sim_CostLeave(Sim_Cost_t* const Cost)
+{
+	if (--Cost->Depth)
+	  return;
+
+	uint32_t CallAccesses    = Accesses - Cost->StartAccesses;
+	uint64_t CallNanoseconds = Sim_FirmwareNanoseconds() - Cost->StartNanoseconds;
+
+	Cost->Calls++;
+	Cost->Accesses    += CallAccesses;
+	Cost->Bytes       += Bytes - Cost->StartBytes;
+	Cost->Nanoseconds += CallNanoseconds;
+
+	if (CallAccesses > Cost->MaxAccesses)
+	  Cost->MaxAccesses = CallAccesses;
+
+	if (CallNanoseconds > Cost->MaxNanoseconds)
+	  Cost->MaxNanoseconds = CallNanoseconds;
+}
@@ -0,0 +1,173 @@
+/** \file
+ *
+ *  Header file for Simulator.c.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <stdbool.h>
+
+	/* Enable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			extern "C" {
+		#endif
+
+	/* Macros: */
+		/** Endpoints of the modelled USB controller, as in the ATmega32U4. */
+		#define SIM_MAX_ENDPOINTS            7
+
+		/** Largest endpoint bank of the modelled USB controller. */
+		#define SIM_MAX_BANK_SIZE            64
+
+		/** Register accesses the firmware makes in one simulated millisecond. The firmware runs one
+		 *  step per access to a modelled register, so this sets how much work fits between two frames.
+		 */
+		#define SIM_STEPS_PER_FRAME          1000
+
+		/** Returned by the Sim_Host* transactions when the endpoint answers with a NAK. */
+		#define SIM_NAK                      -1
+
+		/** Returned by the Sim_Host* transactions when the endpoint answers with a STALL. */
+		#define SIM_STALL                    -2
+
+		/** Returned by the Sim_Host* transactions when the endpoint is not configured. */
+		#define SIM_NO_RESPONSE              -3
+
+	/* Type Defines: */
+		/** Modelled 8-bit registers. Those before \c SIM_MCUSR are computed by the USB controller model
+		 *  on each access, the others only hold what the firmware writes and the host sets.
+		 */
+		typedef enum
+		{
+			SIM_UHWCON,
+			SIM_USBCON,
+			SIM_USBSTA,
+			SIM_USBINT,
+			SIM_UDCON,
+			SIM_UDINT,
+			SIM_UDIEN,
+			SIM_UDADDR,
+			SIM_UENUM,
+			SIM_UERST,
+			SIM_UECONX,
+			SIM_UECFG0X,
+			SIM_UECFG1X,
+			SIM_UESTA0X,
+			SIM_UESTA1X,
+			SIM_UEINTX,
+			SIM_UEIENX,
+			SIM_UEDATX,
+			SIM_UEBCLX,
+			SIM_UEBCHX,
+			SIM_UEINT,
+			SIM_PLLCSR,
+			SIM_PLLFRQ,
+			SIM_SREG,
+			SIM_MCUSR,
+			SIM_PINB,
+			SIM_PINC,
+			SIM_PIND,
+			SIM_PINE,
+			SIM_PORTB,
+			SIM_PORTC,
+			SIM_PORTD,
+			SIM_PORTE,
+			SIM_DDRB,
+			SIM_DDRC,
+			SIM_DDRD,
+			SIM_DDRE,
+			SIM_TCCR1A,
+			SIM_TCCR1B,
+			SIM_TCCR3A,
+			SIM_TCCR3B,
+			SIM_EICRA,
+			SIM_EICRB,
+			SIM_EIFR,
+			SIM_EIMSK,
+			SIM_PCICR,
+			SIM_PCIFR,
+			SIM_PCMSK0,
+			SIM_SMCR,
+			SIM_CLKPR,
+			SIM_NUM_REGISTERS
+		} Sim_Register_t;
+
+		/** Modelled 16-bit registers. */
+		typedef enum
+		{
+			SIM_UDFNUM,
+			SIM_TCNT1,
+			SIM_TCNT3,
+			SIM_NUM_REGISTERS16
+		} Sim_Register16_t;
+
+		/** Cost of a firmware path, gathered while it runs. See Sim_CostEnter(). */
+		typedef struct
+		{
+			const char* Name; /**< Name printed in the cost table. */
+			uint32_t Calls; /**< Times the path ran. */
+			uint32_t Accesses; /**< Accesses to modelled registers, summed over all calls. */
+			uint32_t MaxAccesses; /**< Accesses to modelled registers in the most expensive call. */
+			uint32_t Bytes; /**< Bytes moved through UEDATX, summed over all calls. */
+			uint64_t Nanoseconds; /**< Host time outside the model, summed over all calls. */
+			uint64_t MaxNanoseconds; /**< Host time outside the model in the most expensive call. */
+			uint32_t Depth; /**< Calls in progress, so recursive entries are only counted once. */
+			uint32_t StartAccesses; /**< Sim_Accesses() when the outermost call started. */
+			uint32_t StartBytes; /**< Sim_Bytes() when the outermost call started. */
+			uint64_t StartNanoseconds; /**< Sim_FirmwareNanoseconds() when the outermost call started. */
+		} Sim_Cost_t;
+
+	/* Function Prototypes: */
+		/* Register model, used by the avr/io.h shim: */
+		volatile uint8_t* Sim_IO(const Sim_Register_t Register);
+		volatile uint16_t* Sim_IO16(const Sim_Register16_t Register);
+
+		/* CPU, used by the avr-libc shims: */
+		void Sim_Sei(void);
+		void Sim_Cli(void);
+		void Sim_SleepEnable(const bool Enable);
+		void Sim_Sleep(void);
+		void Sim_DelayMicroseconds(const uint32_t Microseconds);
+		uint8_t Sim_SignatureByte(const uint16_t Address);
+
+		/* Firmware control: */
+		void Sim_Start(void (*const Entry)(void));
+		void Sim_Step(void);
+		bool Sim_RunUntil(bool (*const Done)(void), const uint32_t MaxSteps);
+		void Sim_RunFrames(const uint16_t Frames);
+		bool Sim_IsSleeping(void);
+		uint32_t Sim_Steps(void);
+		void Sim_SetFrameHook(void (*const Hook)(uint16_t FrameNumber));
+		void Sim_SetPins(const Sim_Register_t Port, const uint8_t Mask, const bool Pressed);
+		uint8_t Sim_Peek(const Sim_Register_t Register);
+
+		/* Bus, as seen by the host: */
+		void Sim_HostAttach(void);
+		void Sim_HostReset(void);
+		uint16_t Sim_HostFrameNumber(void);
+		uint8_t Sim_HostAddress(void);
+		int16_t Sim_HostSetup(const uint8_t Endpoint, const void* const Data);
+		int16_t Sim_HostOut(const uint8_t Endpoint, const void* const Data, const uint8_t Length);
+		int16_t Sim_HostIn(const uint8_t Endpoint, void* const Data, const uint8_t MaxLength);
+		uint8_t Sim_HostBusyBanks(const uint8_t Endpoint);
+		bool Sim_HostIsConfigured(const uint8_t Endpoint);
+
+		/* Cost accounting: */
+		uint32_t Sim_Accesses(void);
+		uint32_t Sim_Bytes(void);
+		uint64_t Sim_FirmwareNanoseconds(void);
+		void Sim_CostEnter(Sim_Cost_t* const Cost);
+		void Sim_CostLeave(Sim_Cost_t* const Cost);
+		const Sim_Cost_t* Sim_InterruptCost(const bool Endpoint);
+
+	/* Disable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			}
+		#endif
+
+#endif
+
@@ -0,0 +1,271 @@
+/** \file
+ *
+ *  Configuration feature report, written and read back through HID SetReport and GetReport
+ *  requests, which the firmware handles in HID_Device_ProcessControlRequest(). Each rejected
+ *  report also changes a valid setting, so accepting it by mistake shows up in the read back.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Joystick.h"
+#include "Host.h"
+
+/** Joystick interface number, the wIndex of its class requests. */
+#define JOYSTICK_INTERFACE           0
+
+/** Button 1 and button 2 inputs, see inputMap in Joystick.c. */
+#define INPUT_1                      (1 << 5)
+#define INPUT_2                      (1 << 4)
+
+extern "C" int Firmware_Main(void);
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+/** Reads the configuration feature report, checking its report ID. */
+static USB_JoystickConfigReport_Data_t GetConfig(void)
+{
+	const Host_Request_t GetReport = {0xA1, HID_REQ_GetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Config,
+	                                  JOYSTICK_INTERFACE, 1 + sizeof(USB_JoystickConfigReport_Data_t)};
+	uint8_t Data[1 + sizeof(USB_JoystickConfigReport_Data_t) + HOST_CONTROL_SIZE];
+	USB_JoystickConfigReport_Data_t Config;
+
+	Host_Expect(Host_ControlRead(&GetReport, Data) == GetReport.wLength, "GetReport returns the whole report");
+	Host_Expect(Data[0] == HID_REPORTID_Config, "GetReport returns the configuration report ID");
+
+	memcpy(&Config, &Data[1], sizeof(Config));
+	return Config;
+}
+
+/** Writes the configuration feature report with \c Length bytes after the report ID, and lets
+ *  the main loop apply it.
+ */
+static void SetConfig(const USB_JoystickConfigReport_Data_t& Config,
+                      const uint16_t Length = sizeof(USB_JoystickConfigReport_Data_t))
+{
+	const Host_Request_t SetReport = {0x21, HID_REQ_SetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Config,
+	                                  JOYSTICK_INTERFACE, static_cast<uint16_t>(1 + Length)};
+	uint8_t Data[1 + sizeof(USB_JoystickConfigReport_Data_t)] = {HID_REPORTID_Config};
+
+	memcpy(&Data[1], &Config, sizeof(Config));
+	Host_Expect(Host_ControlWrite(&SetReport, Data) == SetReport.wLength, "SetReport is acknowledged");
+	Sim_RunFrames(5);
+}
+
+static bool SameSettings(const USB_JoystickConfigReport_Data_t& A, const USB_JoystickConfigReport_Data_t& B)
+{
+	return !memcmp(&A, &B, sizeof(A));
+}
+
+/** Writes a report that must be rejected, after also changing a valid setting in it. */
+static void ExpectRejected(USB_JoystickConfigReport_Data_t Config, const char* const What,
+                           const uint16_t Length = sizeof(USB_JoystickConfigReport_Data_t))
+{
+	const USB_JoystickConfigReport_Data_t Current = GetConfig();
+
+	Config.DebouncePressTicks++;
+	SetConfig(Config, Length);
+
+	Host_Expect(SameSettings(GetConfig(), Current), What);
+}
+
+/** Waits for the next input report and returns its button bits. */
+static uint16_t NextButtons(void)
+{
+	Host_Report_t Report;
+
+	Host_ClearReports();
+	Sim_RunFrames(10);
+
+	while (Host_NextReport(&Report))
+	{
+		if (Report.Data[0] != HID_REPORTID_Joystick)
+		  continue;
+
+		uint16_t Buttons = Report.Data[1] | (Report.Data[2] << 8);
+
+		if (!Host_NextReport(&Report))
+		  return Buttons;
+	}
+
+	return 0;
+}
+
+/** Holds the first input for \c Frames frames and returns the button bits of the reports read
+ *  meanwhile, ORed together up to the first report with a button pressed, and ANDed from it on.
+ */
+static void PressFor(const uint16_t Frames, uint16_t* const FirstPressed, uint16_t* const AlwaysPressed)
+{
+	Host_Report_t Report;
+	bool          Pressed = false;
+
+	*FirstPressed  = 0;
+	*AlwaysPressed = 0;
+
+	Host_ClearReports();
+	Sim_SetPins(SIM_PINB, INPUT_1, true);
+	Sim_RunFrames(Frames);
+	Sim_SetPins(SIM_PINB, INPUT_1, false);
+
+	while (Host_NextReport(&Report))
+	{
+		if (Report.Data[0] != HID_REPORTID_Joystick)
+		  continue;
+
+		uint16_t Buttons = Report.Data[1] | (Report.Data[2] << 8);
+
+		if (Pressed)
+		{
+			*AlwaysPressed &= Buttons;
+		}
+		else
+		{
+			*FirstPressed |= Buttons;
+			*AlwaysPressed = Buttons;
+		}
+
+		Pressed |= (Buttons != 0);
+	}
+
+	Sim_RunFrames(10);
+}
+
+int main(void)
+{
+	Host_Boot(Firmware);
+	Host_Enumerate();
+	Host_PollInterrupt(JOYSTICK_EPADDR, 1);
+
+	USB_JoystickConfigReport_Data_t Config = GetConfig();
+
+	Host_Expect(Config.Version == CONFIG_REPORT_VERSION, "configuration report has the current version");
+	Host_Expect(Config.Flags == 0, "configuration report flags read as zero");
+
+	/* A valid report is applied: swap the first two buttons and change every other setting */
+	for (uint8_t Button = 0; Button < NUM_BUTTONS; Button++)
+	{
+		Config.ButtonOrder[Button] = Button;
+		Config.TurboRate[Button]   = TURBO_OFF;
+	}
+
+	Config.ButtonOrder[0]       = 1;
+	Config.ButtonOrder[1]       = 0;
+	Config.TurboRate[9]         = TURBO_NUM_RATES;
+	Config.SocdPolicy           = SOCD_NUM_POLICIES - 1;
+	Config.DebouncePressTicks   = 3;
+	Config.DebounceReleaseTicks = 4;
+	Config.DebounceLockoutTicks = 5;
+	Config.DebounceEager        = 1;
+	SetConfig(Config);
+
+	Host_Expect(SameSettings(GetConfig(), Config), "valid configuration is applied");
+
+	Sim_SetPins(SIM_PINB, INPUT_1, true);
+	Host_Expect(NextButtons() == (1 << 1), "first input is reported as the second button");
+	Sim_SetPins(SIM_PINB, INPUT_1, false);
+	Host_Expect(NextButtons() == 0, "released input is reported as released");
+
+	/* ButtonOrder must be a permutation of the buttons */
+	USB_JoystickConfigReport_Data_t Invalid = Config;
+	Invalid.ButtonOrder[1] = Invalid.ButtonOrder[0];
+	ExpectRejected(Invalid, "button order with a repeated input is rejected");
+
+	Invalid = Config;
+	Invalid.ButtonOrder[0] = NUM_BUTTONS;
+	ExpectRejected(Invalid, "button order with an input out of range is rejected");
+
+	Invalid = Config;
+	Invalid.ButtonOrder[0] = 0xFF;
+	Invalid.ButtonOrder[1] = 0xFF;
+	ExpectRejected(Invalid, "button order with unused inputs is rejected");
+
+	/* Out of range enumerations */
+	Invalid = Config;
+	Invalid.TurboRate[0] = TURBO_NUM_RATES + 1;
+	ExpectRejected(Invalid, "turbo rate out of range is rejected");
+
+	Invalid = Config;
+	Invalid.SocdPolicy = SOCD_NUM_POLICIES;
+	ExpectRejected(Invalid, "SOCD policy out of range is rejected");
+
+	/* Layout checks */
+	Invalid = Config;
+	Invalid.Version = CONFIG_REPORT_VERSION + 1;
+	ExpectRejected(Invalid, "report with another version is rejected");
+
+	ExpectRejected(Config, "report shorter than the layout is rejected", sizeof(Config) - 1);
+	ExpectRejected(Config, "report with only the report ID is rejected", 0);
+
+	/* Read only and write only fields are ignored */
+	Config.PollingIntervalMS++;
+	Config.DebouncePressTicks = 6;
+	SetConfig(Config);
+	Config.PollingIntervalMS--;
+	Host_Expect(SameSettings(GetConfig(), Config), "polling interval is read only");
+
+	/* A turbo press is reported at once, wherever the shared phase is */
+	Config.TurboRate[1] = TURBO_10HZ;
+	SetConfig(Config);
+
+	for (uint8_t Press = 0; Press < 4; Press++)
+	{
+		uint16_t FirstPressed, AlwaysPressed;
+
+		PressFor(Config.DebouncePressTicks + 5, &FirstPressed, &AlwaysPressed);
+		Host_Expect(FirstPressed == (1 << 1), "turbo button is reported as soon as it is pressed");
+
+		/* Let the next press land in another part of the period */
+		Sim_RunFrames(37);
+	}
+
+	uint16_t FirstPressed, AlwaysPressed;
+
+	PressFor(60, &FirstPressed, &AlwaysPressed);
+	Host_Expect(FirstPressed == (1 << 1), "held turbo button is reported pressed");
+	Host_Expect(AlwaysPressed == 0, "held turbo button is reported released after at most a half period");
+
+	/* Buttons with the same rate toggle together, however far apart they were pressed */
+	Config.TurboRate[0] = TURBO_10HZ;
+	SetConfig(Config);
+
+	for (uint8_t Offset = 7; Offset < 80; Offset += 36)
+	{
+		Host_Report_t Report;
+		uint16_t      Toggles = 0, PrevButtons = 0;
+		bool          Locked = true;
+
+		Sim_SetPins(SIM_PINB, INPUT_1, true);
+		Sim_RunFrames(Offset);
+		Sim_SetPins(SIM_PINB, INPUT_2, true);
+		Sim_RunFrames(Config.DebouncePressTicks + 5);
+
+		Host_ClearReports();
+		Sim_RunFrames(300);
+		Sim_SetPins(SIM_PINB, INPUT_1 | INPUT_2, false);
+
+		while (Host_NextReport(&Report))
+		{
+			if (Report.Data[0] != HID_REPORTID_Joystick)
+			  continue;
+
+			uint16_t Buttons = (Report.Data[1] | (Report.Data[2] << 8)) & 0x03;
+
+			Locked  &= (Buttons == 0) || (Buttons == 0x03);
+			Toggles += (Buttons != PrevButtons);
+			PrevButtons = Buttons;
+		}
+
+		Host_Expect(Locked, "turbo buttons with the same rate are phase-locked");
+		Host_Expect(Toggles >= 5, "phase-locked turbo buttons keep toggling");
+
+		Sim_RunFrames(20);
+	}
+
+	printf("%s: %d failures\n", __FILE__, Host_Failures());
+	return Host_Failures() ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+/** \file
+ *
+ *  Non-blocking control transfers (ASYNC_CONTROL_TRANSFERS): descriptor, HID report and trace
+ *  requests are answered from the control endpoint interrupt, one packet per interrupt, while the
+ *  joystick endpoint keeps being polled. Covers the zero length packet ending a data stage that is
+ *  a multiple of the packet size, a status stage sent before the whole data stage was read, and a
+ *  new SETUP abandoning a transfer in progress.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Joystick.h"
+#include "Host.h"
+
+/** Joystick interface number, the wIndex of its class requests. */
+#define JOYSTICK_INTERFACE           0
+
+/** Button 1 input, see inputMap in Joystick.c. */
+#define INPUT_1                      (1 << 5)
+
+int Firmware_Main(void);
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+static bool StreamIdle(void)
+{
+	return !Endpoint_IsControlStreamActive();
+}
+
+/** Sends the SETUP packet of a control read and takes only the first \c Packets data packets. */
+static void StartRead(const Host_Request_t* const Request, void* const Data, const uint8_t Packets)
+{
+	uint8_t* Bytes = Data;
+
+	Sim_HostSetup(0, Request);
+
+	for (uint8_t Packet = 0; Packet < Packets; Packet++)
+	  Host_Expect(Host_WaitIn(0, &Bytes[Packet * HOST_CONTROL_SIZE], HOST_CONTROL_SIZE) == HOST_CONTROL_SIZE,
+	              "data stage packet is full");
+}
+
+static void TestDescriptors(void)
+{
+	const Host_Request_t GetDevice  = {0x80, 0x06, 0x0100, 0x0000, 64};
+	const Host_Request_t GetConfig  = {0x80, 0x06, 0x0200, 0x0000, 255};
+	const Host_Request_t GetProduct = {0x80, 0x06, 0x0302, 0x0409, 255};
+	uint8_t Device[64 + HOST_CONTROL_SIZE];
+	uint8_t Data[255 + HOST_CONTROL_SIZE];
+
+	Host_Expect(Host_ControlRead(&GetDevice, Device) == 18, "device descriptor is read");
+
+	/* The product string is a multiple of the packet size: a zero length packet ends it if the host asked
+	 * for more, none is queued if the host asked for exactly that much */
+	int16_t Length = Host_ControlRead(&GetProduct, Data);
+
+	Host_Expect((Length > 0) && !(Length % HOST_CONTROL_SIZE), "product string is a multiple of the packet size");
+
+	Host_Request_t GetProductExact = GetProduct;
+	GetProductExact.wLength = Length;
+
+	StartRead(&GetProductExact, Data, Length / HOST_CONTROL_SIZE);
+	Sim_RunFrames(1);
+	Host_Expect(Sim_HostBusyBanks(0) == 0, "no zero length packet follows a data stage of exactly wLength");
+	Host_Expect(Host_WaitOut(0, NULL, 0) == 0, "status stage is acknowledged");
+	Host_Expect(Sim_RunUntil(StreamIdle, SIM_STEPS_PER_FRAME), "transfer completes with the status stage");
+
+	/* Status stage before the whole data stage was read */
+	StartRead(&GetDevice, Data, 1);
+	Host_Expect(Host_WaitOut(0, NULL, 0) == 0, "early status stage is acknowledged");
+	Host_Expect(Sim_RunUntil(StreamIdle, SIM_STEPS_PER_FRAME), "early status stage ends the transfer");
+	Host_Expect(!memcmp(Data, Device, HOST_CONTROL_SIZE), "early status stage data is the descriptor start");
+	Host_Expect(Host_ControlRead(&GetDevice, Data) == 18, "request after an early status stage is answered");
+	Host_Expect(!memcmp(Data, Device, 18), "request after an early status stage is answered in full");
+
+	/* New SETUP in the middle of a data stage */
+	StartRead(&GetConfig, Data, 1);
+	Host_Expect(Endpoint_IsControlStreamActive(), "transfer waits for the host to read on");
+	Host_Expect(Host_ControlRead(&GetDevice, Data) == 18, "new SETUP abandons the transfer in progress");
+	Host_Expect(!memcmp(Data, Device, 18), "new request is answered in full");
+}
+
+static void TestReports(void)
+{
+	const Host_Request_t GetConfig = {0xA1, HID_REQ_GetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Config,
+	                                  JOYSTICK_INTERFACE, 255};
+	const Host_Request_t GetInput  = {0xA1, HID_REQ_GetReport, (HID_REPORT_ITEM_In + 1) << 8 | HID_REPORTID_Joystick,
+	                                  JOYSTICK_INTERFACE, 255};
+	uint8_t Data[255 + HOST_CONTROL_SIZE];
+	USB_JoystickConfigReport_Data_t Config;
+
+	Host_Expect(Host_ControlRead(&GetInput, Data) == 1 + sizeof(USB_JoystickReport_Data_t), "input report is read");
+	Host_Expect(Data[0] == HID_REPORTID_Joystick, "input report starts with its ID");
+
+	#if defined(TRACK_EDGE_LATENCY)
+	const Host_Request_t GetStats  = {0xA1, HID_REQ_GetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Stats,
+	                                  JOYSTICK_INTERFACE, 255};
+
+	Host_Expect(Host_ControlRead(&GetStats, Data) == 1 + sizeof(USB_JoystickStatsReport_Data_t), "stats report is read");
+	Host_Expect(Data[0] == HID_REPORTID_Stats, "stats report starts with its ID");
+
+	StartRead(&GetStats, Data, 1);
+	Host_Expect(Endpoint_IsControlStreamActive(), "GetReport data stage is sent from the interrupt");
+	Host_Expect(Host_WaitOut(0, NULL, 0) == 0, "early status stage of a GetReport is acknowledged");
+	#endif
+
+	Host_Expect(Host_ControlRead(&GetConfig, Data) == 1 + sizeof(Config), "configuration report is read");
+	Host_Expect(Data[0] == HID_REPORTID_Config, "configuration report starts with its ID");
+	memcpy(&Config, &Data[1], sizeof(Config));
+
+	/* SetReport data stage, received from the interrupt and handed to the application once complete */
+	const Host_Request_t SetConfig = {0x21, HID_REQ_SetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Config,
+	                                  JOYSTICK_INTERFACE, 1 + sizeof(Config)};
+
+	Config.DebouncePressTicks++;
+	Data[0] = HID_REPORTID_Config;
+	memcpy(&Data[1], &Config, sizeof(Config));
+	Host_Expect(Host_ControlWrite(&SetConfig, Data) == SetConfig.wLength, "configuration report is written");
+	Sim_RunFrames(5);
+
+	Host_Expect(Host_ControlRead(&GetConfig, Data) == 1 + sizeof(Config), "configuration report is read back");
+	Host_Expect(!memcmp(&Data[1], &Config, sizeof(Config)), "written configuration is applied");
+
+	/* Reports that do not fit the driver buffer are refused */
+	Host_Request_t SetLong = SetConfig;
+	SetLong.wLength = 200;
+	Host_Expect(Host_ControlWrite(&SetLong, Data) == SIM_STALL, "oversized SetReport is stalled");
+}
+
+#if defined(TRACE_HOT_PATHS)
+static void TestTrace(void)
+{
+	const Host_Request_t ReadTrace = {0xC0, TRACE_REQUEST_READ, 0, 0, 255};
+	const Host_Request_t WorstISR  = {0xC0, TRACE_REQUEST_WORST_ISR, 0, 0, 2};
+	uint8_t Data[255 + HOST_CONTROL_SIZE];
+
+	StartRead(&ReadTrace, Data, 1);
+	Host_Expect(Endpoint_IsControlStreamActive(), "trace data stage is sent from the interrupt");
+	Host_Expect(Host_WaitOut(0, NULL, 0) == 0, "early status stage of a trace read is acknowledged");
+
+	Host_Expect(Host_ControlRead(&WorstISR, Data) == 2, "worst interrupt time is read");
+	Host_Expect(Data[0] || Data[1], "worst interrupt time was measured");
+
+	/* The ring is full by now, so a whole read of events is returned, ending with a zero length packet if it
+	 * is a multiple of the packet size */
+	Host_Expect(Host_ControlRead(&ReadTrace, Data) == TRACE_READ_MAX * sizeof(Trace_Event_t), "trace events are read");
+	Host_Expect(StreamIdle(), "trace read completes");
+}
+#endif
+
+/** Reads the report descriptor one packet every few frames, as a slow host would, while the joystick
+ *  endpoint is polled and a button pressed.
+ */
+static void TestInterleaved(void)
+{
+	const Host_Request_t GetReportDescriptor = {0x81, 0x06, 0x2200, JOYSTICK_INTERFACE, 255};
+	uint8_t Data[255 + HOST_CONTROL_SIZE];
+	int16_t Total = 0;
+	int16_t Length;
+	bool    Pressed = false;
+	Host_Report_t Report;
+
+	Host_PollInterrupt(JOYSTICK_EPADDR, 1);
+	Sim_RunFrames(5);
+	Host_ClearReports();
+
+	Sim_HostSetup(0, &GetReportDescriptor);
+	Sim_SetPins(SIM_PINB, INPUT_1, true);
+
+	do
+	{
+		Sim_RunFrames(3);
+		Host_Expect(Endpoint_IsControlStreamActive(), "descriptor transfer is still in progress");
+
+		while (Host_NextReport(&Report))
+		  Pressed |= (Report.Data[0] == HID_REPORTID_Joystick) && (Report.Data[1] & 0x01);
+
+		if ((Length = Host_WaitIn(0, &Data[Total], HOST_CONTROL_SIZE)) < 0)
+		  break;
+
+		Total += Length;
+	}
+	while (Length == HOST_CONTROL_SIZE);
+
+	Host_Expect(Pressed, "button press is reported during the control transfer");
+	Host_Expect(Host_WaitOut(0, NULL, 0) == 0, "status stage is acknowledged");
+	Host_Expect(Sim_RunUntil(StreamIdle, SIM_STEPS_PER_FRAME), "slow transfer completes");
+	Host_Expect(Total > 0, "report descriptor is read");
+
+	Sim_SetPins(SIM_PINB, INPUT_1, false);
+	Host_PollInterrupt(JOYSTICK_EPADDR, 0);
+}
+
+#if defined(TRACK_EDGE_LATENCY)
+/** Reads the worst input edge to report latency from the statistics report, after the button presses
+ *  of the other tests, and clears it.
+ */
+static void TestWorstLatency(void)
+{
+	const Host_Request_t GetStats = {0xA1, HID_REQ_GetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Stats,
+	                                 JOYSTICK_INTERFACE, 1 + sizeof(USB_JoystickStatsReport_Data_t)};
+	const Host_Request_t SetStats = {0x21, HID_REQ_SetReport, (HID_REPORT_ITEM_Feature + 1) << 8 | HID_REPORTID_Stats,
+	                                 JOYSTICK_INTERFACE, 1};
+	uint8_t Data[1 + sizeof(USB_JoystickStatsReport_Data_t) + HOST_CONTROL_SIZE];
+	USB_JoystickStatsReport_Data_t Stats;
+
+	Host_Expect(Host_ControlRead(&GetStats, Data) == GetStats.wLength, "stats report is read");
+	memcpy(&Stats, &Data[1], sizeof(Stats));
+	Host_Expect(Stats.WorstEdgeToReport != 0, "worst input edge to report latency is measured");
+
+	Data[0] = HID_REPORTID_Stats;
+	Host_Expect(Host_ControlWrite(&SetStats, Data) == SetStats.wLength, "stats report is written");
+	Host_Expect(Host_ControlRead(&GetStats, Data) == GetStats.wLength, "stats report is read back");
+	memcpy(&Stats, &Data[1], sizeof(Stats));
+	Host_Expect(Stats.WorstEdgeToReport == 0, "writing the stats report clears the worst latency");
+}
+#endif
+
+int main(void)
+{
+	Host_Boot(Firmware);
+	Host_Expect(Host_Enumerate(), "device enumerates through non-blocking transfers");
+
+	TestDescriptors();
+	TestReports();
+	#if defined(TRACE_HOT_PATHS)
+	TestTrace();
+	#endif
+	TestInterleaved();
+	#if defined(TRACK_EDGE_LATENCY)
+	TestWorstLatency();
+	#endif
+
+	printf("%s: %d failures\n", __FILE__, Host_Failures());
+	return Host_Failures() ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/** \file
+ *
+ *  Sequencing of the double banked joystick endpoint, with the host not reading it while the
+ *  buttons change: a new report replaces the one queued in the last bank, while the first bank,
+ *  which the host may already be reading, keeps the report it was loaded with.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <avr/io.h>
+
+#include "Descriptors.h"
+#include "Host.h"
+
+/** Button 1 and button 2 inputs, see inputMap in Joystick.c. */
+#define BUTTON_1                     (1 << 5)
+#define BUTTON_2                     (1 << 4)
+
+int Firmware_Main(void);
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+/** Reads one report from the joystick endpoint, returning its button byte or -1 on a NAK. */
+static int16_t ReadButtons(void)
+{
+	uint8_t Data[HOST_MAX_REPORT];
+	int16_t Length = Sim_HostIn(JOYSTICK_EPADDR, Data, sizeof(Data));
+
+	if (Length == SIM_NAK)
+	  return -1;
+
+	Host_Expect((Length > 1) && (Data[0] == 1), "joystick endpoint sends input reports");
+	return Data[1];
+}
+
+int main(void)
+{
+	Host_Boot(Firmware);
+	Host_Enumerate();
+
+	/* The report loaded after SET_CONFIGURATION stays queued in the first bank */
+	Sim_RunFrames(10);
+	Host_Expect(Sim_HostBusyBanks(JOYSTICK_EPADDR) == 1, "initial report queued in one bank");
+
+	Sim_SetPins(SIM_PINB, BUTTON_1, true);
+	Sim_RunFrames(10);
+	Host_Expect(Sim_HostBusyBanks(JOYSTICK_EPADDR) == 2, "button 1 report queued in the second bank");
+
+	Sim_SetPins(SIM_PINB, BUTTON_2, true);
+	Sim_RunFrames(10);
+	Host_Expect(Sim_HostBusyBanks(JOYSTICK_EPADDR) == 2, "button 2 report replaces the second bank");
+
+	Host_Expect(ReadButtons() == 0x00, "first bank keeps the older report");
+	Host_Expect(ReadButtons() == 0x03, "second bank holds the latest report");
+	Host_Expect(ReadButtons() == -1, "report with button 1 alone is never sent");
+
+	/* With the banks drained, the next change goes out in a free bank again */
+	Sim_SetPins(SIM_PINB, BUTTON_1 | BUTTON_2, false);
+	Sim_RunFrames(10);
+	Host_Expect(Sim_HostBusyBanks(JOYSTICK_EPADDR) == 1, "release report queued in one bank");
+	Host_Expect(ReadButtons() == 0x00, "release report sent");
+
+	printf("%s: %d failures\n", __FILE__, Host_Failures());
+	return Host_Failures() ? 1 : 0;
+}
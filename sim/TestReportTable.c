@@ -0,0 +1,281 @@
+/** \file
+ *
+ *  HID interface issuing several input reports, as a composite device built on the joystick would:
+ *  two report IDs created through the driver's ReportINTable, each with its own change detection
+ *  and idle period, next to a report published through the ReportINBuffers double buffer. This
+ *  program brings its own firmware instead of Joystick.c, and reuses the joystick descriptors,
+ *  whose report descriptor the host model does not parse.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+
+#include "LUFA/Drivers/USB/USB.h"
+#include "Descriptors.h"
+#include "Host.h"
+
+/** Report IDs of the two table reports, and of the published report. */
+#define REPORT_ID_A                  4
+#define REPORT_ID_B                  5
+#define REPORT_ID_PUBLISHED          6
+
+/** Index of the report counters of each report ID. */
+#define COUNT_A                      0
+#define COUNT_B                      1
+#define COUNT_PUBLISHED              2
+#define COUNT_OTHER                  3
+
+static uint8_t PrevReportA[2];
+static uint8_t PrevReportB[2];
+static uint8_t PublishBuffers[2][1 + 1];
+
+static const USB_ClassInfo_HID_Device_ReportIN_t ReportINs[] =
+{
+	{.ReportID = REPORT_ID_A, .PrevReportINBuffer = PrevReportA, .PrevReportINBufferSize = sizeof(PrevReportA)},
+	{.ReportID = REPORT_ID_B, .PrevReportINBuffer = PrevReportB, .PrevReportINBufferSize = sizeof(PrevReportB)},
+};
+
+static USB_ClassInfo_HID_Device_t Composite_HID_Interface =
+	{
+		.Config =
+			{
+				.InterfaceNumber        = INTERFACE_ID_Joystick,
+				.ReportINEndpoint       =
+					{
+						.Address        = JOYSTICK_EPADDR,
+						.Size           = JOYSTICK_EPSIZE,
+						.Banks          = 1,
+					},
+				.PrevReportINBuffer     = NULL,
+				.PrevReportINBufferSize = sizeof(PrevReportA),
+				.ReportINBuffers        = PublishBuffers,
+				.ReportINBufferSize     = sizeof(PublishBuffers[0]),
+				.ReportINTable          = ReportINs,
+				.TotalReportINs         = sizeof(ReportINs) / sizeof(ReportINs[0]),
+			},
+	};
+
+/** Contents of the table reports, set by the host side of the test. */
+static uint16_t ReportA;
+static uint16_t ReportB;
+
+/** Next value of the published report, published by the firmware main loop when set. */
+static uint8_t PublishValue;
+static bool    PublishPending;
+
+int Firmware_Main(void)
+{
+	USB_Init();
+	GlobalInterruptEnable();
+
+	for (;;)
+	{
+		if (PublishPending)
+		{
+			PublishPending = false;
+
+			*(uint8_t*)HID_Device_GetPublishBuffer(&Composite_HID_Interface) = PublishValue;
+			HID_Device_PublishReport(&Composite_HID_Interface, REPORT_ID_PUBLISHED, 1, true);
+		}
+
+		#if !defined(INTERRUPT_HID_ENDPOINT)
+		HID_Device_USBTask(&Composite_HID_Interface);
+		#endif
+		USB_USBTask();
+	}
+}
+
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	HID_Device_ConfigureEndpoints(&Composite_HID_Interface);
+	USB_Device_EnableSOFEvents();
+}
+
+void EVENT_USB_Device_ControlRequest(void)
+{
+	HID_Device_ProcessControlRequest(&Composite_HID_Interface);
+}
+
+void EVENT_USB_Device_StartOfFrame(void)
+{
+	HID_Device_MillisecondElapsed(&Composite_HID_Interface);
+}
+
+#if defined(INTERRUPT_HID_ENDPOINT)
+void EVENT_USB_Device_EndpointInterrupt(const uint8_t EndpointMask)
+{
+	HID_Device_ProcessEndpointInterrupt(&Composite_HID_Interface, EndpointMask);
+}
+#endif
+
+bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                         uint8_t* const ReportID,
+                                         const uint8_t ReportType,
+                                         void* ReportData,
+                                         uint16_t* const ReportSize)
+{
+	uint16_t Report;
+
+	switch (*ReportID)
+	{
+		case REPORT_ID_A:
+			Report = ReportA;
+			break;
+		case REPORT_ID_B:
+			Report = ReportB;
+			break;
+		default:
+			return false;
+	}
+
+	memcpy(ReportData, &Report, sizeof(Report));
+	*ReportSize = sizeof(Report);
+	return false;
+}
+
+void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                          const uint8_t ReportID,
+                                          const uint8_t ReportType,
+                                          const void* ReportData,
+                                          const uint16_t ReportSize)
+{
+}
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+/** Runs \c Frames frames, counting the reports of each ID read by the poller. Reports must come at
+ *  most one per frame, and the last one of each table ID read is kept in \c Last.
+ */
+static void CountReports(const uint16_t Frames, uint8_t Counts[4], uint16_t Last[2])
+{
+	Host_Report_t Report;
+	uint16_t      PrevFrame = 0xFFFF;
+
+	memset(Counts, 0, 4);
+
+	Host_ClearReports();
+	Sim_RunFrames(Frames);
+
+	while (Host_NextReport(&Report))
+	{
+		uint16_t Value = Report.Data[1] | (Report.Data[2] << 8);
+
+		Host_Expect(Report.Frame != PrevFrame, "one report is sent per frame");
+		PrevFrame = Report.Frame;
+
+		switch (Report.Data[0])
+		{
+			case REPORT_ID_A:
+				Counts[COUNT_A]++;
+				Last[0] = Value;
+				break;
+			case REPORT_ID_B:
+				Counts[COUNT_B]++;
+				Last[1] = Value;
+				break;
+			case REPORT_ID_PUBLISHED:
+				Counts[COUNT_PUBLISHED]++;
+				break;
+			default:
+				Counts[COUNT_OTHER]++;
+				break;
+		}
+	}
+
+	Host_Expect(Counts[COUNT_OTHER] == 0, "only the table and published report IDs are sent");
+}
+
+static void SetIdle(const uint8_t ReportID, const uint8_t Duration)
+{
+	const Host_Request_t SetIdle = {0x21, HID_REQ_SetIdle, (Duration << 8) | ReportID, INTERFACE_ID_Joystick, 0};
+
+	Host_Expect(Host_ControlWrite(&SetIdle, NULL) == 0, "SET_IDLE is acknowledged");
+}
+
+static uint8_t GetIdle(const uint8_t ReportID)
+{
+	const Host_Request_t GetIdle = {0xA1, HID_REQ_GetIdle, ReportID, INTERFACE_ID_Joystick, 1};
+	uint8_t Data[1 + HOST_CONTROL_SIZE] = {0xFF};
+
+	Host_Expect(Host_ControlRead(&GetIdle, Data) == 1, "GET_IDLE returns the idle duration");
+	return Data[0];
+}
+
+int main(void)
+{
+	uint8_t  Counts[4];
+	uint16_t Last[2] = {0, 0};
+
+	Host_Boot(Firmware);
+	Host_Enumerate();
+	Host_PollInterrupt(JOYSTICK_EPADDR, 1);
+
+	/* Read the report loaded on the default idle period, before enumeration set an infinite one on every
+	 * report, so that unchanged reports are not sent any more */
+	Sim_RunFrames(5);
+	CountReports(50, Counts, Last);
+	Host_Expect(!Counts[COUNT_A] && !Counts[COUNT_B] && !Counts[COUNT_PUBLISHED], "unchanged reports are not sent");
+
+	/* Each table report is compared against its own previous report */
+	ReportA = 0x1234;
+	CountReports(10, Counts, Last);
+	Host_Expect(Counts[COUNT_A] == 1 && Last[0] == 0x1234, "changed report A is sent once");
+	Host_Expect(!Counts[COUNT_B] && !Counts[COUNT_PUBLISHED], "unchanged reports stay quiet when report A changes");
+
+	ReportB = 0x5678;
+	CountReports(10, Counts, Last);
+	Host_Expect(Counts[COUNT_B] == 1 && Last[1] == 0x5678, "changed report B is sent once");
+	Host_Expect(!Counts[COUNT_A] && !Counts[COUNT_PUBLISHED], "unchanged reports stay quiet when report B changes");
+
+	/* The published report is sent next to the table */
+	PublishValue   = 0x9A;
+	PublishPending = true;
+	CountReports(10, Counts, Last);
+	Host_Expect(Counts[COUNT_PUBLISHED] == 1, "published report is sent next to the table reports");
+	Host_Expect(!Counts[COUNT_A] && !Counts[COUNT_B], "table reports stay quiet when a report is published");
+
+	/* All three change in the same frame: each is sent, one per frame */
+	ReportA++;
+	ReportB++;
+	PublishValue++;
+	PublishPending = true;
+	CountReports(10, Counts, Last);
+	Host_Expect(Counts[COUNT_A] == 1 && Counts[COUNT_B] == 1 && Counts[COUNT_PUBLISHED] == 1,
+	            "reports changed together are all sent");
+
+	/* SET_IDLE with a report ID only sets the idle period of that report */
+	SetIdle(REPORT_ID_B, 10);
+	Host_Expect(GetIdle(REPORT_ID_B) == 10, "GET_IDLE returns the idle duration of report B");
+	Host_Expect(GetIdle(REPORT_ID_A) == 0, "SET_IDLE of report B leaves report A alone");
+	Host_Expect(GetIdle(REPORT_ID_PUBLISHED) == 0, "SET_IDLE of report B leaves the published report alone");
+
+	CountReports(200, Counts, Last);
+	Host_Expect(Counts[COUNT_B] >= 4 && Counts[COUNT_B] <= 6, "report B repeats on its 40 ms idle period");
+	Host_Expect(!Counts[COUNT_A] && !Counts[COUNT_PUBLISHED], "reports with an infinite idle period are not repeated");
+
+	SetIdle(REPORT_ID_PUBLISHED, 5);
+	Host_Expect(GetIdle(REPORT_ID_PUBLISHED) == 5, "GET_IDLE returns the idle duration of the published report");
+	Host_Expect(GetIdle(REPORT_ID_B) == 10, "SET_IDLE of the published report leaves report B alone");
+
+	CountReports(200, Counts, Last);
+	Host_Expect(Counts[COUNT_PUBLISHED] >= 8 && Counts[COUNT_PUBLISHED] <= 11, "published report repeats on its 20 ms idle period");
+	Host_Expect(Counts[COUNT_B] >= 4 && Counts[COUNT_B] <= 6, "report B keeps its own idle period");
+	Host_Expect(!Counts[COUNT_A], "report A is still not repeated");
+
+	/* Report ID zero sets every report */
+	SetIdle(0, 0);
+	Host_Expect(!GetIdle(REPORT_ID_A) && !GetIdle(REPORT_ID_B) && !GetIdle(REPORT_ID_PUBLISHED),
+	            "SET_IDLE of report ID zero sets every report");
+
+	CountReports(100, Counts, Last);
+	Host_Expect(!Counts[COUNT_A] && !Counts[COUNT_B] && !Counts[COUNT_PUBLISHED], "no report repeats after SET_IDLE zero");
+
+	printf("%s: %d failures\n", __FILE__, Host_Failures());
+	return Host_Failures() ? 1 : 0;
+}
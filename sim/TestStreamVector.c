@@ -0,0 +1,197 @@
+/** \file
+ *
+ *  Scattered writes through Endpoint_Write_Stream_Vector(): segments from RAM, FLASH and EEPROM
+ *  are sent back to back, packets span segment boundaries, zero length segments are skipped and
+ *  a transfer ending on a bank boundary is terminated by a zero length packet. This program
+ *  brings its own firmware instead of Joystick.c, and reuses the joystick descriptors, writing
+ *  to the joystick endpoint reconfigured with small banks.
+ *
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+
+#include "LUFA/Drivers/USB/USB.h"
+#include "Descriptors.h"
+#include "Host.h"
+
+/** Endpoint written by the firmware, and its bank size. */
+#define STREAM_EPADDR                JOYSTICK_EPADDR
+#define STREAM_EPSIZE                8
+
+/** Longest transfer of the test cases, in bytes. */
+#define STREAM_MAX_LENGTH            64
+
+static uint8_t       RamData[STREAM_MAX_LENGTH];
+static const uint8_t PROGMEM FlashData[STREAM_MAX_LENGTH] = {0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+                                                            0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF};
+static uint8_t       EEMEM EepromData[STREAM_MAX_LENGTH] = {0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7};
+
+/** Segments for the firmware main loop to write, set by the host side of the test. */
+static const USB_Endpoint_Segment_t* PendingSegments;
+static uint8_t                       PendingTotal;
+
+/** Error code returned by the last write. */
+static uint8_t WriteErrorCode;
+
+int Firmware_Main(void)
+{
+	USB_Init();
+	GlobalInterruptEnable();
+
+	for (;;)
+	{
+		if (PendingSegments != NULL)
+		{
+			Endpoint_SelectEndpoint(STREAM_EPADDR);
+			WriteErrorCode  = Endpoint_Write_Stream_Vector(PendingSegments, PendingTotal, NULL);
+			PendingSegments = NULL;
+		}
+
+		USB_USBTask();
+	}
+}
+
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	Endpoint_ConfigureEndpoint(STREAM_EPADDR, EP_TYPE_BULK, STREAM_EPSIZE, 1);
+}
+
+void EVENT_USB_Device_ControlRequest(void)
+{
+	/* Acknowledge the SET_IDLE request sent by the host model during enumeration */
+	if ((USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE)) &&
+	    (USB_ControlRequest.bRequest == HID_REQ_SetIdle))
+	{
+		Endpoint_ClearSETUP();
+		Endpoint_ClearStatusStage();
+	}
+}
+
+/* The HID class driver is linked into every sim program, but this firmware has no HID interface */
+bool CALLBACK_HID_Device_CreateHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                         uint8_t* const ReportID,
+                                         const uint8_t ReportType,
+                                         void* ReportData,
+                                         uint16_t* const ReportSize)
+{
+	return false;
+}
+
+void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                          const uint8_t ReportID,
+                                          const uint8_t ReportType,
+                                          const void* ReportData,
+                                          const uint16_t ReportSize)
+{
+}
+
+static void Firmware(void)
+{
+	Firmware_Main();
+}
+
+/** Has the firmware write the given segments, and reads the whole transfer, up to its first short
+ *  packet. The length of each packet read is stored in \c PacketLengths.
+ *
+ *  \return Number of packets read, or zero if the device stopped answering.
+ */
+static uint8_t WriteSegments(const USB_Endpoint_Segment_t* const Segments, const uint8_t TotalSegments,
+                             uint8_t* const Data, uint8_t* const PacketLengths)
+{
+	uint8_t  TotalPackets = 0;
+	uint16_t Received     = 0;
+	int16_t  Length;
+
+	PendingSegments = Segments;
+	PendingTotal    = TotalSegments;
+
+	do
+	{
+		if ((Length = Host_WaitIn(STREAM_EPADDR, &Data[Received], STREAM_EPSIZE)) < 0)
+		  return 0;
+
+		PacketLengths[TotalPackets++] = Length;
+		Received += Length;
+	}
+	while ((Length == STREAM_EPSIZE) && (Received <= STREAM_MAX_LENGTH));
+
+	Sim_RunFrames(2);
+	Host_Expect(PendingSegments == NULL, "stream write returns once the transfer is read");
+	Host_Expect(WriteErrorCode == ENDPOINT_RWSTREAM_NoError, "stream write succeeds");
+
+	return TotalPackets;
+}
+
+int main(void)
+{
+	uint8_t Data[STREAM_MAX_LENGTH + STREAM_EPSIZE];
+	uint8_t PacketLengths[STREAM_MAX_LENGTH / STREAM_EPSIZE + 2];
+	uint8_t Expected[STREAM_MAX_LENGTH];
+
+	for (uint8_t i = 0; i < sizeof(RamData); i++)
+	  RamData[i] = i;
+
+	Host_Boot(Firmware);
+	Host_Enumerate();
+
+	/* Segments from every memory space, packed across bank boundaries, end with a short packet */
+	const USB_Endpoint_Segment_t Mixed[] =
+		{
+			{.Buffer = RamData,    .Length = 5, .MemorySpace = MEMSPACE_RAM},
+			{.Buffer = FlashData,  .Length = 6, .MemorySpace = MEMSPACE_FLASH},
+			{.Buffer = EepromData, .Length = 7, .MemorySpace = MEMSPACE_EEPROM},
+		};
+
+	memcpy(&Expected[0], RamData, 5);
+	memcpy(&Expected[5], FlashData, 6);
+	memcpy(&Expected[11], EepromData, 7);
+
+	Host_Expect(WriteSegments(Mixed, 3, Data, PacketLengths) == 3, "18 bytes are sent in three packets");
+	Host_Expect((PacketLengths[0] == 8) && (PacketLengths[1] == 8) && (PacketLengths[2] == 2),
+	            "segments are packed into full packets across bank boundaries");
+	Host_Expect(!memcmp(Data, Expected, 18), "segments are sent back to back, in order");
+
+	/* A transfer ending on a bank boundary is terminated by a zero length packet */
+	const USB_Endpoint_Segment_t Exact[] =
+		{
+			{.Buffer = RamData,   .Length = 3,  .MemorySpace = MEMSPACE_RAM},
+			{.Buffer = FlashData, .Length = 13, .MemorySpace = MEMSPACE_FLASH},
+		};
+
+	memcpy(&Expected[0], RamData, 3);
+	memcpy(&Expected[3], FlashData, 13);
+
+	Host_Expect(WriteSegments(Exact, 2, Data, PacketLengths) == 3, "16 bytes are sent in two packets and a ZLP");
+	Host_Expect((PacketLengths[0] == 8) && (PacketLengths[1] == 8) && (PacketLengths[2] == 0),
+	            "transfer ending on a bank boundary is terminated by a zero length packet");
+	Host_Expect(!memcmp(Data, Expected, 16), "exact multiple of the bank size is sent whole");
+
+	/* Zero length segments add nothing, wherever they are */
+	const USB_Endpoint_Segment_t Empty[] =
+		{
+			{.Buffer = RamData,    .Length = 0, .MemorySpace = MEMSPACE_RAM},
+			{.Buffer = FlashData,  .Length = 4, .MemorySpace = MEMSPACE_FLASH},
+			{.Buffer = EepromData, .Length = 0, .MemorySpace = MEMSPACE_EEPROM},
+			{.Buffer = RamData,    .Length = 6, .MemorySpace = MEMSPACE_RAM},
+			{.Buffer = FlashData,  .Length = 0, .MemorySpace = MEMSPACE_FLASH},
+		};
+
+	memcpy(&Expected[0], FlashData, 4);
+	memcpy(&Expected[4], RamData, 6);
+
+	Host_Expect(WriteSegments(Empty, 5, Data, PacketLengths) == 2, "10 bytes are sent in two packets");
+	Host_Expect((PacketLengths[0] == 8) && (PacketLengths[1] == 2), "zero length segments are skipped");
+	Host_Expect(!memcmp(Data, Expected, 10), "zero length segments add no data");
+
+	/* Nothing at all to send is a single zero length packet */
+	Host_Expect(WriteSegments(Empty, 1, Data, PacketLengths) == 1, "empty transfer is one packet");
+	Host_Expect(PacketLengths[0] == 0, "empty transfer is a zero length packet");
+
+	printf("%s: %d failures\n", __FILE__, Host_Failures());
+	return Host_Failures() ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/boot.h>, for the internal serial number.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_BOOT_H_
+#define _SIM_AVR_BOOT_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+	/* Macros: */
+		#define boot_signature_byte_get(a)    Sim_SignatureByte(a)
+
+#endif
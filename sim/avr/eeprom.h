@@ -0,0 +1,53 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/eeprom.h>. EEMEM variables are plain variables, starting with
+ *  their initializers as if the .eep file had been programmed.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_EEPROM_H_
+#define _SIM_AVR_EEPROM_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <string.h>
+
+	/* Macros: */
+		#define EEMEM
+
+	/* Inline Functions: */
+		static inline uint8_t eeprom_read_byte(const uint8_t* Address)
+		{
+			return *Address;
+		}
+
+		static inline uint16_t eeprom_read_word(const uint16_t* Address)
+		{
+			return *Address;
+		}
+
+		static inline void eeprom_read_block(void* Destination, const void* Source, size_t Length)
+		{
+			memcpy(Destination, Source, Length);
+		}
+
+		static inline void eeprom_update_byte(uint8_t* Address, uint8_t Value)
+		{
+			*Address = Value;
+		}
+
+		static inline void eeprom_update_word(uint16_t* Address, uint16_t Value)
+		{
+			*Address = Value;
+		}
+
+		static inline void eeprom_update_block(const void* Source, void* Destination, size_t Length)
+		{
+			memcpy(Destination, Source, Length);
+		}
+
+		#define eeprom_write_byte    eeprom_update_byte
+		#define eeprom_write_word    eeprom_update_word
+		#define eeprom_write_block   eeprom_update_block
+
+#endif
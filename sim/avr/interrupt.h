@@ -0,0 +1,26 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/interrupt.h>. Handlers become plain functions, called by the
+ *  simulator when their interrupt is enabled and pending.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_INTERRUPT_H_
+#define _SIM_AVR_INTERRUPT_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+	/* Macros: */
+		#define ISR_BLOCK
+		#define ISR_NOBLOCK
+		#define ISR_NAKED
+		#define ISR_ALIASOF(v)
+
+		#define ISR(vector, ...)     void vector(void); void vector(void)
+
+		#define sei()                Sim_Sei()
+		#define cli()                Sim_Cli()
+		#define reti()               return
+
+#endif
@@ -0,0 +1,233 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/io.h>, for the ATmega32U4. Registers of the USB controller, the
+ *  timers and the ports are routed through the register model of Simulator.c, bits keep their
+ *  datasheet positions.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_IO_H_
+#define _SIM_AVR_IO_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include "../Simulator.h"
+
+	/* Macros: */
+		#define _BV(bit)             (1 << (bit))
+		#define _SFR_MEM_ADDR(sfr)   ((uint16_t)(uintptr_t)&(sfr))
+
+		#define UHWCON               (*Sim_IO(SIM_UHWCON))
+		#define USBCON               (*Sim_IO(SIM_USBCON))
+		#define USBSTA               (*Sim_IO(SIM_USBSTA))
+		#define USBINT               (*Sim_IO(SIM_USBINT))
+		#define UDCON                (*Sim_IO(SIM_UDCON))
+		#define UDINT                (*Sim_IO(SIM_UDINT))
+		#define UDIEN                (*Sim_IO(SIM_UDIEN))
+		#define UDADDR               (*Sim_IO(SIM_UDADDR))
+		#define UDFNUM               (*Sim_IO16(SIM_UDFNUM))
+		#define UENUM                (*Sim_IO(SIM_UENUM))
+		#define UERST                (*Sim_IO(SIM_UERST))
+		#define UECONX               (*Sim_IO(SIM_UECONX))
+		#define UECFG0X              (*Sim_IO(SIM_UECFG0X))
+		#define UECFG1X              (*Sim_IO(SIM_UECFG1X))
+		#define UESTA0X              (*Sim_IO(SIM_UESTA0X))
+		#define UESTA1X              (*Sim_IO(SIM_UESTA1X))
+		#define UEINTX               (*Sim_IO(SIM_UEINTX))
+		#define UEIENX               (*Sim_IO(SIM_UEIENX))
+		#define UEDATX               (*Sim_IO(SIM_UEDATX))
+		#define UEBCLX               (*Sim_IO(SIM_UEBCLX))
+		#define UEBCHX               (*Sim_IO(SIM_UEBCHX))
+		#define UEINT                (*Sim_IO(SIM_UEINT))
+		#define PLLCSR               (*Sim_IO(SIM_PLLCSR))
+		#define PLLFRQ               (*Sim_IO(SIM_PLLFRQ))
+		#define SREG                 (*Sim_IO(SIM_SREG))
+		#define MCUSR                (*Sim_IO(SIM_MCUSR))
+		#define PINB                 (*Sim_IO(SIM_PINB))
+		#define PINC                 (*Sim_IO(SIM_PINC))
+		#define PIND                 (*Sim_IO(SIM_PIND))
+		#define PINE                 (*Sim_IO(SIM_PINE))
+		#define PORTB                (*Sim_IO(SIM_PORTB))
+		#define PORTC                (*Sim_IO(SIM_PORTC))
+		#define PORTD                (*Sim_IO(SIM_PORTD))
+		#define PORTE                (*Sim_IO(SIM_PORTE))
+		#define DDRB                 (*Sim_IO(SIM_DDRB))
+		#define DDRC                 (*Sim_IO(SIM_DDRC))
+		#define DDRD                 (*Sim_IO(SIM_DDRD))
+		#define DDRE                 (*Sim_IO(SIM_DDRE))
+		#define TCCR1A               (*Sim_IO(SIM_TCCR1A))
+		#define TCCR1B               (*Sim_IO(SIM_TCCR1B))
+		#define TCNT1                (*Sim_IO16(SIM_TCNT1))
+		#define TCCR3A               (*Sim_IO(SIM_TCCR3A))
+		#define TCCR3B               (*Sim_IO(SIM_TCCR3B))
+		#define TCNT3                (*Sim_IO16(SIM_TCNT3))
+		#define EICRA                (*Sim_IO(SIM_EICRA))
+		#define EICRB                (*Sim_IO(SIM_EICRB))
+		#define EIFR                 (*Sim_IO(SIM_EIFR))
+		#define EIMSK                (*Sim_IO(SIM_EIMSK))
+		#define PCICR                (*Sim_IO(SIM_PCICR))
+		#define PCIFR                (*Sim_IO(SIM_PCIFR))
+		#define PCMSK0               (*Sim_IO(SIM_PCMSK0))
+		#define SMCR                 (*Sim_IO(SIM_SMCR))
+		#define CLKPR                (*Sim_IO(SIM_CLKPR))
+
+		/* UHWCON */
+		#define UVREGE               0
+		/* USBCON */
+		#define USBE                 7
+		#define FRZCLK               5
+		#define OTGPADE              4
+		#define VBUSTE               0
+		/* USBSTA */
+		#define ID                   1
+		#define VBUS                 0
+		/* USBINT */
+		#define VBUSTI               0
+		/* UDCON */
+		#define RSTCPU               3
+		#define LSM                  2
+		#define RMWKUP               1
+		#define DETACH               0
+		/* UDINT, UDIEN */
+		#define UPRSMI               6
+		#define EORSMI               5
+		#define WAKEUPI              4
+		#define EORSTI               3
+		#define SOFI                 2
+		#define SUSPI                0
+		#define UPRSME               6
+		#define EORSME               5
+		#define WAKEUPE              4
+		#define EORSTE               3
+		#define SOFE                 2
+		#define SUSPE                0
+		/* UDADDR */
+		#define ADDEN                7
+		/* UECONX */
+		#define STALLRQ              5
+		#define STALLRQC             4
+		#define RSTDT                3
+		#define EPEN                 0
+		/* UECFG0X */
+		#define EPTYPE1              7
+		#define EPTYPE0              6
+		#define EPDIR                0
+		/* UECFG1X */
+		#define EPSIZE2              6
+		#define EPSIZE1              5
+		#define EPSIZE0              4
+		#define EPBK1                3
+		#define EPBK0                2
+		#define ALLOC                1
+		/* UESTA0X */
+		#define CFGOK                7
+		#define OVERFI               6
+		#define UNDERFI              5
+		#define DTSEQ1               3
+		#define DTSEQ0               2
+		#define NBUSYBK1             1
+		#define NBUSYBK0             0
+		/* UESTA1X */
+		#define CTRLDIR              2
+		#define CURRBK1              1
+		#define CURRBK0              0
+		/* UEINTX */
+		#define FIFOCON              7
+		#define NAKINI               6
+		#define RWAL                 5
+		#define NAKOUTI              4
+		#define RXSTPI               3
+		#define RXOUTI               2
+		#define KILLBK               2
+		#define STALLEDI             1
+		#define TXINI                0
+		/* UEIENX */
+		#define FLERRE               7
+		#define NAKINE               6
+		#define NAKOUTE              4
+		#define RXSTPE               3
+		#define RXOUTE               2
+		#define STALLEDE             1
+		#define TXINE                0
+		/* PLLCSR */
+		#define PINDIV               4
+		#define PLLE                 1
+		#define PLOCK                0
+		/* PLLFRQ */
+		#define PINMUX               7
+		#define PLLUSB               6
+		#define PLLTM1               5
+		#define PLLTM0               4
+		#define PDIV3                3
+		#define PDIV2                2
+		#define PDIV1                1
+		#define PDIV0                0
+		/* MCUSR */
+		#define JTRF                 4
+		#define WDRF                 3
+		#define BORF                 2
+		#define EXTRF                1
+		#define PORF                 0
+		/* TCCR1B, TCCR3B */
+		#define CS12                 2
+		#define CS11                 1
+		#define CS10                 0
+		#define CS32                 2
+		#define CS31                 1
+		#define CS30                 0
+		/* EICRB, EIMSK, EIFR */
+		#define ISC61                5
+		#define ISC60                4
+		#define INT6                 6
+		#define INTF6                6
+		/* EICRA */
+		#define ISC31                7
+		#define ISC30                6
+		#define ISC21                5
+		#define ISC20                4
+		#define ISC11                3
+		#define ISC10                2
+		#define ISC01                1
+		#define ISC00                0
+		#define INT3                 3
+		#define INT2                 2
+		#define INT1                 1
+		#define INT0                 0
+		/* PCICR, PCIFR */
+		#define PCIE0                0
+		#define PCIF0                0
+		/* SMCR */
+		#define SM2                  3
+		#define SM1                  2
+		#define SM0                  1
+		#define SE                   0
+		/* Port pins */
+		#define PB7                  7
+		#define PB6                  6
+		#define PB5                  5
+		#define PB4                  4
+		#define PB3                  3
+		#define PB2                  2
+		#define PB1                  1
+		#define PB0                  0
+		#define PC7                  7
+		#define PC6                  6
+		#define PD7                  7
+		#define PD6                  6
+		#define PD5                  5
+		#define PD4                  4
+		#define PD3                  3
+		#define PD2                  2
+		#define PD1                  1
+		#define PD0                  0
+		#define PE6                  6
+		#define PE2                  2
+
+		#define SIGNATURE_0          0x1E
+		#define SIGNATURE_1          0x95
+		#define SIGNATURE_2          0x87
+
+		#define RAMEND               0x0AFF
+		#define E2END                0x03FF
+
+#endif
@@ -0,0 +1,30 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/pgmspace.h>. The host has a single address space, so FLASH
+ *  reads are plain reads.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_PGMSPACE_H_
+#define _SIM_AVR_PGMSPACE_H_
+
+	/* Includes: */
+		#include <stdint.h>
+		#include <string.h>
+
+	/* Macros: */
+		#define PROGMEM
+		#define PSTR(s)              (s)
+		#define PGM_P                const char*
+
+		#define pgm_read_byte(a)     (*(const uint8_t*)(a))
+		#define pgm_read_word(a)     (*(const uint16_t*)(a))
+		#define pgm_read_dword(a)    (*(const uint32_t*)(a))
+
+		#define memcpy_P             memcpy
+		#define memcmp_P             memcmp
+		#define strlen_P             strlen
+		#define strcpy_P             strcpy
+		#define printf_P             printf
+
+#endif
@@ -0,0 +1,14 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/power.h>. Clocks are not modelled.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_POWER_H_
+#define _SIM_AVR_POWER_H_
+
+	/* Macros: */
+		#define clock_div_1              0
+		#define clock_prescale_set(x)    ((void)(x))
+
+#endif
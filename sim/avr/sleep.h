@@ -0,0 +1,24 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/sleep.h>. A sleeping MCU hands the bus over to the host until
+ *  an enabled interrupt is pending.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_SLEEP_H_
+#define _SIM_AVR_SLEEP_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+	/* Macros: */
+		#define SLEEP_MODE_IDLE          0
+		#define SLEEP_MODE_PWR_DOWN      (1 << SM1)
+
+		#define set_sleep_mode(m)        (SMCR = (SMCR & (1 << SE)) | (m))
+		#define sleep_enable()           Sim_SleepEnable(true)
+		#define sleep_disable()          Sim_SleepEnable(false)
+		#define sleep_cpu()              Sim_Sleep()
+		#define sleep_mode()             do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#endif
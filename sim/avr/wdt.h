@@ -0,0 +1,16 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <avr/wdt.h>. The watchdog is not modelled.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_AVR_WDT_H_
+#define _SIM_AVR_WDT_H_
+
+	/* Macros: */
+		#define WDTO_15MS                0
+		#define wdt_disable()            ((void)0)
+		#define wdt_reset()              ((void)0)
+		#define wdt_enable(x)            ((void)(x))
+
+#endif
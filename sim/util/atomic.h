@@ -0,0 +1,38 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <util/atomic.h>.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_UTIL_ATOMIC_H_
+#define _SIM_UTIL_ATOMIC_H_
+
+	/* Includes: */
+		#include <avr/interrupt.h>
+
+	/* Inline Functions: */
+		static inline uint8_t Sim_AtomicStart(void)
+		{
+			uint8_t State = SREG;
+			cli();
+			return State;
+		}
+
+		static inline void Sim_AtomicRestore(const uint8_t* const State)
+		{
+			SREG = *State;
+		}
+
+		static inline void Sim_AtomicForceOn(const uint8_t* const State)
+		{
+			(void)State;
+			sei();
+		}
+
+	/* Macros: */
+		#define ATOMIC_RESTORESTATE      uint8_t Sim_AtomicState __attribute__((__cleanup__(Sim_AtomicRestore))) = Sim_AtomicStart()
+		#define ATOMIC_FORCEON           uint8_t Sim_AtomicState __attribute__((__cleanup__(Sim_AtomicForceOn))) = Sim_AtomicStart()
+
+		#define ATOMIC_BLOCK(type)       for (type, Sim_AtomicDone = 1; Sim_AtomicDone; Sim_AtomicDone = 0)
+
+#endif
@@ -0,0 +1,17 @@
+/** \file
+ *
+ *  Host stand-in for avr-libc's <util/delay.h>. Delays let the host run for the same time.
+ *  (C) 2016 André Luiz de Amorim, licensed under GPLv3.
+ */
+
+#ifndef _SIM_UTIL_DELAY_H_
+#define _SIM_UTIL_DELAY_H_
+
+	/* Includes: */
+		#include <avr/io.h>
+
+	/* Macros: */
+		#define _delay_ms(ms)            Sim_DelayMicroseconds((uint32_t)((ms) * 1000))
+		#define _delay_us(us)            Sim_DelayMicroseconds((uint32_t)(us))
+
+#endif